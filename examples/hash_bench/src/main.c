@@ -0,0 +1,127 @@
+/* SGFX tile hash bench — times every sgfx_hash engine over a 320x480 frame split
+ * into 16x16 tiles, for RGB565 and RGBA8888 pixel sizes, chained row by row the
+ * way sgfx_fb_rehash_tiles() does.
+ *
+ * Host (run from the repo root):
+ *   cc -std=c99 -O2 -Iinclude examples/hash_bench/src/main.c src/core/sgfx_hash.c -o sgfx_hash_bench
+ *
+ * Options: -DBENCH_W=... -DBENCH_H=... -DBENCH_TILE=... -DBENCH_ITERS=...
+ *          -DBENCH_SPI_HZ=... (reference transfer time for one RGB565 frame)
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sgfx_hash.h"
+
+#ifndef BENCH_W
+#define BENCH_W 320
+#endif
+#ifndef BENCH_H
+#define BENCH_H 480
+#endif
+#ifndef BENCH_TILE
+#define BENCH_TILE 16
+#endif
+#ifndef BENCH_ITERS
+#define BENCH_ITERS 50
+#endif
+#ifndef BENCH_SPI_HZ
+#define BENCH_SPI_HZ 40000000
+#endif
+
+static const struct { const char* name; sgfx_hash_fn fn; } ENGINES[] = {
+  { "crc32-bitwise", sgfx_hash_crc32_bitwise },
+  { "crc32-slice8",  sgfx_hash_crc32 },
+  { "word32",        sgfx_hash_word32 },
+  { "fast64",        sgfx_hash_fast64 },
+};
+#define NENG (int)(sizeof ENGINES / sizeof ENGINES[0])
+
+static double now_ms(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Hash all tiles once; returns a checksum so the work cannot be optimised out. */
+static uint32_t hash_frame(sgfx_hash_fn fn, const uint8_t* px, int stride, int bpp, uint32_t* out){
+  const int TX = (BENCH_W + BENCH_TILE - 1) / BENCH_TILE, TY = (BENCH_H + BENCH_TILE - 1) / BENCH_TILE;
+  uint32_t sum = 0;
+  for (int ty = 0; ty < TY; ++ty)
+    for (int tx = 0; tx < TX; ++tx){
+      int x = tx * BENCH_TILE, y = ty * BENCH_TILE;
+      int tw = x + BENCH_TILE > BENCH_W ? BENCH_W - x : BENCH_TILE;
+      int th = y + BENCH_TILE > BENCH_H ? BENCH_H - y : BENCH_TILE;
+      const uint8_t* base = px + (size_t)y * stride + (size_t)x * bpp;
+      uint32_t h = 0;
+      for (int j = 0; j < th; ++j) h = fn(h, base + (size_t)j * stride, (size_t)tw * bpp);
+      if (out) out[ty * TX + tx] = h;
+      sum += h;
+    }
+  return sum;
+}
+
+/* UI-like content: flat panels, gradients and some noise. */
+static void fill_frame(uint8_t* px, size_t bytes){
+  srand(7);
+  for (size_t i = 0; i < bytes; ++i){
+    size_t row = i / 1024;
+    px[i] = (row % 3 == 0) ? 0x20 : (row % 3 == 1) ? (uint8_t)i : (uint8_t)rand();
+  }
+}
+
+/* Flip one bit in every tile and count tiles whose hash did not change. */
+static int missed_changes(sgfx_hash_fn fn, uint8_t* px, int stride, int bpp){
+  const int TX = (BENCH_W + BENCH_TILE - 1) / BENCH_TILE, TY = (BENCH_H + BENCH_TILE - 1) / BENCH_TILE;
+  uint32_t* a = (uint32_t*)malloc(sizeof(uint32_t) * TX * TY);
+  uint32_t* b = (uint32_t*)malloc(sizeof(uint32_t) * TX * TY);
+  hash_frame(fn, px, stride, bpp, a);
+  for (int t = 0; t < TX * TY; ++t){
+    int x = (t % TX) * BENCH_TILE + t % 5, y = (t / TX) * BENCH_TILE + t % 7;
+    if (x >= BENCH_W) x = BENCH_W - 1;
+    if (y >= BENCH_H) y = BENCH_H - 1;
+    px[(size_t)y * stride + (size_t)x * bpp] ^= (uint8_t)(1u << (t & 7));
+  }
+  hash_frame(fn, px, stride, bpp, b);
+  int missed = 0;
+  for (int t = 0; t < TX * TY; ++t) missed += a[t] == b[t];
+  free(a); free(b);
+  return missed;
+}
+
+int main(void){
+  const double spi_ms = (double)BENCH_W * BENCH_H * 16.0 / BENCH_SPI_HZ * 1e3;
+  printf("%dx%d, %dx%d tiles, %d iters; RGB565 frame at %.0f MHz SPI: %.2f ms\n",
+         BENCH_W, BENCH_H, BENCH_TILE, BENCH_TILE, BENCH_ITERS, BENCH_SPI_HZ / 1e6, spi_ms);
+
+  static const int BPP[] = { 2, 4 };
+  static const char* FMT[] = { "RGB565", "RGBA8888" };
+  for (int f = 0; f < 2; ++f){
+    int bpp = BPP[f], stride = BENCH_W * bpp;
+    size_t bytes = (size_t)stride * BENCH_H;
+    uint8_t* px = (uint8_t*)malloc(bytes);
+    if (!px) return 1;
+    fill_frame(px, bytes);
+
+    /* slice-by-8 must agree with the reference CRC */
+    if (hash_frame(sgfx_hash_crc32, px, stride, bpp, NULL) != hash_frame(sgfx_hash_crc32_bitwise, px, stride, bpp, NULL)){
+      printf("crc32-slice8 disagrees with the bitwise reference\n");
+      return 1;
+    }
+
+    printf("\n%-9s %-14s %10s %10s %9s %7s\n", FMT[f], "engine", "ms/frame", "MB/s", "% of SPI", "missed");
+    for (int e = 0; e < NENG; ++e){
+      volatile uint32_t sink = 0;
+      double t0 = now_ms();
+      for (int it = 0; it < BENCH_ITERS; ++it) sink += hash_frame(ENGINES[e].fn, px, stride, bpp, NULL);
+      double ms = (now_ms() - t0) / BENCH_ITERS;
+      (void)sink;
+      printf("%-9s %-14s %10.3f %10.1f %8.1f%% %7d\n", "", ENGINES[e].name, ms,
+             bytes / (ms * 1e3), 100.0 * ms / spi_ms, missed_changes(ENGINES[e].fn, px, stride, bpp));
+    }
+    free(px);
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+/* SGFX host bench — drives a real driver into the virtual panel and prints bus cost per frame.
+ *
+ * ST7789 240x320 (run from the repo root):
+ *   cc -std=c99 -O2 -Iinclude -DSGFX_HAL_VIRTUAL -DSGFX_BUS_SPI -DSGFX_DRV_ST7789 -DSGFX_RGB565_BYTESWAP
+ *      -DSGFX_W=240 -DSGFX_H=320 -DSGFX_PIN_SCK=-1 -DSGFX_PIN_MOSI=-1 -DSGFX_PIN_MISO=-1
+ *      -DSGFX_PIN_CS=-1 -DSGFX_PIN_DC=-1 -DSGFX_PIN_RST=-1 -DSGFX_PIN_BL=-1 -DSGFX_SPI_HZ=0
+ *      examples/host_virtual/src/main.c src/hal/virtual/virtual_panel.c src/drivers/st7789.c
+ *      src/drivers/mipi_dcs.c src/core/gfx_core.c src/core/sgfx_fb.c src/core/sgfx_hash.c src/core/sgfx_present.c
+ *      src/core/sgfx_fb_fmt.c
+ *      -o sgfx_host_bench -lm
+ *
+ * SSD1306 128x64: use -DSGFX_BUS_I2C -DSGFX_DRV_SSD1306 -DSGFX_W=128 -DSGFX_H=64
+ *   -DSGFX_PIN_SDA=-1 -DSGFX_PIN_SCL=-1 -DSGFX_PIN_RST=-1 -DSGFX_PIN_BL=-1
+ *   -DSGFX_I2C_ADDR=0x3C -DSGFX_I2C_HZ=0 and src/drivers/ssd1306.c instead.
+ *
+ * The virtual bus sends RGB565 in memory order like the MCU HALs, so little-endian
+ * hosts need -DSGFX_RGB565_BYTESWAP (as ESP32 targets do) for matching colours.
+ * Build with -DBENCH_SYNC to present with blocking writes instead of the async queue.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sgfx.h"
+#include "sgfx_fb.h"
+#include "sgfx_port.h"
+#include "sgfx_virtual.h"
+
+#if defined(SGFX_DRV_SSD1306)
+# define BENCH_KIND SGFX_VPANEL_SSD1306
+#else
+# define BENCH_KIND SGFX_VPANEL_ST77XX
+#endif
+
+static uint8_t scratch[4096];
+
+static void print_frame(const char* name, const sgfx_vpanel_t* vp, const sgfx_present_t* pr){
+  const sgfx_vpanel_stats_t* s = &vp->stats;
+  printf("%-14s cmds=%6u data=%8u addr=%5u win=%5u ramwr=%5u px=%7u drop=%u cs=%6u\n",
+         name, (unsigned)s->cmds, (unsigned)s->data_bytes, (unsigned)s->addr_cmds,
+         (unsigned)s->windows, (unsigned)s->ram_writes, (unsigned)s->px_written,
+         (unsigned)s->px_dropped, (unsigned)s->cs_toggles);
+  if (!pr) return;
+  const sgfx_present_stats_t* p = &pr->stats;
+  printf("%-14s rects=%u merged=%u overdraw=%u tiles=%u xfers=%u waits=%u solid=%u/%u saved=%u\n", "",
+         (unsigned)p->rects_pushed, (unsigned)p->rects_merged,
+         (unsigned)p->px_overdraw, (unsigned)p->tiles_dirty,
+         (unsigned)p->async_xfers, (unsigned)p->async_waits,
+         (unsigned)p->solid_rects, (unsigned)p->solid_rows, (unsigned)p->bytes_saved);
+}
+
+static void begin_frame(sgfx_vpanel_t* vp, sgfx_present_t* pr){
+  sgfx_vpanel_stats_reset(vp);
+  sgfx_present_stats_reset(&pr->stats);
+}
+
+/* Compare panel RAM against the framebuffer (RGB565 FB, rotation 0, no offsets).
+ * SSD1306 page RAM: a pixel is lit iff the FB pixel is not black (no dither). */
+static int verify(const sgfx_vpanel_t* vp, const sgfx_fb_t* fb){
+#if defined(SGFX_COLOR_RGB565)
+  int bad = 0;
+  for (int y = 0; y < fb->h; ++y){
+    const uint16_t* row = (const uint16_t*)(fb->px + (size_t)y * fb->stride);
+    for (int x = 0; x < fb->w; ++x){
+#if defined(SGFX_DRV_SSD1306)
+      bad += (sgfx_vpanel_pixel565(vp, x, y) != 0) != (row[x] != 0);
+#else
+      bad += sgfx_vpanel_pixel565(vp, x, y) != row[x];
+#endif
+    }
+  }
+  return bad;
+#else
+  (void)vp; (void)fb; return 0;
+#endif
+}
+
+int main(void){
+  sgfx_vpanel_t vp;
+  sgfx_bus_t bus;
+  sgfx_device_t dev;
+  if (sgfx_vpanel_create(&vp, BENCH_KIND, SGFX_W, SGFX_H)) return 1;
+  sgfx_vpanel_make_bus(&bus, &vp);
+
+  sgfx_caps_t caps = *SGFX__DRV_CAPS;
+  caps.width = SGFX_W; caps.height = SGFX_H;
+  if (sgfx_init(&dev, &bus, SGFX__DRV_OPS, &caps, scratch, sizeof scratch)) return 1;
+  print_frame("init", &vp, NULL);
+
+  sgfx_fb_t fb; sgfx_present_t pr;
+  if (sgfx_fb_create(&fb, SGFX_W, SGFX_H, 16, 16)) return 1;
+#ifdef BENCH_SYNC
+  if (sgfx_present_init(&pr, SGFX_W)) return 1;
+#else
+  if (sgfx_present_init_async(&pr, SGFX_W, 2)) return 1;
+#endif
+
+  const sgfx_rgba8_t black = {0,0,0,255}, white = {255,255,255,255}, red = {255,0,0,255};
+
+  begin_frame(&vp, &pr);
+  sgfx_fb_fill_rect_px(&fb, 0, 0, fb.w, fb.h, black);
+  sgfx_present_frame(&pr, &dev, &fb);
+  print_frame("full clear", &vp, &pr);
+
+  begin_frame(&vp, &pr);
+  sgfx_fb_fill_rect_px(&fb, 16, 16, 48, 64, white);
+  sgfx_present_frame(&pr, &dev, &fb);
+  print_frame("3x4 tiles", &vp, &pr);
+
+  begin_frame(&vp, &pr);
+  sgfx_fb_fill_rect_px(&fb, 5, 5, 1, 1, red);
+  sgfx_present_frame(&pr, &dev, &fb);
+  print_frame("1 px", &vp, &pr);
+
+  /* no solid rows: every tile goes through write_pixels (SSD1306: one page
+   * byte per 8 px, so ~W*H/8 data bytes) */
+  begin_frame(&vp, &pr);
+  sgfx_fb_fill_rect_px(&fb, 0, 0, fb.w, fb.h, black);
+  for (int y = 0; y < fb.h; ++y)
+    for (int x = y & 1; x < fb.w; x += 2) sgfx_fb_fill_rect_px(&fb, x, y, 1, 1, white);
+  sgfx_present_frame(&pr, &dev, &fb);
+  print_frame("checker", &vp, &pr);
+  printf("mismatched px: %d\n", verify(&vp, &fb));
+
+  /* window cache: a meter growing down one tile column reuses the columns of
+   * the previous frame and continues at the row below it (RAMWRC, addr=0) */
+  for (int i = 0; i < 2; ++i){
+    begin_frame(&vp, &pr);
+    sgfx_fb_fill_rect_px(&fb, 16, i * 32, 16, 32, red);
+    sgfx_present_frame(&pr, &dev, &fb);
+    print_frame(i ? "meter step" : "meter start", &vp, &pr);
+  }
+  printf("mismatched px: %d\n", verify(&vp, &fb));
+
+  /* two tile columns from the meter's top row: RASET is kept, only CASET goes */
+  begin_frame(&vp, &pr);
+  sgfx_fb_fill_rect_px(&fb, 16, 0, 32, 32, white);
+  sgfx_fb_fill_rect_px(&fb, 24, 8, 16, 16, red);
+  sgfx_present_frame(&pr, &dev, &fb);
+  print_frame("sprite 2 cols", &vp, &pr);
+  printf("mismatched px: %d\n", verify(&vp, &fb));
+
+#if !defined(SGFX_DRV_SSD1306)
+  /* stacked 8x40 strips straight to the panel: one CASET/RASET, then RAMWRC.
+   * The fb gets the same pixels without going dirty so verify() still holds. */
+  begin_frame(&vp, &pr);
+  for (int y = 0; y + 40 <= fb.h; y += 40){
+    const sgfx_rgba8_t c = (y / 40) & 1 ? white : red;
+    sgfx_fill_rect(&dev, 96, y, 8, 40, c);
+    sgfx_fb_fill_rect_px(&fb, 96, y, 8, 40, c);
+  }
+  sgfx_fb_clear_dirty_tiles(&fb, 96 / fb.tile_w, 96 / fb.tile_w, 0, fb.tiles_y - 1);
+  print_frame("8x40 strips", &vp, NULL);
+  printf("mismatched px: %d\n", verify(&vp, &fb));
+#endif
+
+  begin_frame(&vp, &pr);
+  sgfx_present_frame(&pr, &dev, &fb);
+  print_frame("idle", &vp, &pr);
+
+  printf("mismatched px: %d\n", verify(&vp, &fb));
+  sgfx_vpanel_dump_ppm(&vp, "sgfx_host_bench.ppm");
+
+  sgfx_present_deinit(&pr);
+  sgfx_fb_destroy(&fb);
+  sgfx_vpanel_destroy(&vp);
+  return 0;
+}
@@ -0,0 +1,102 @@
+/* SGFX SDF raster check — compares the 16.16 fixed-point SDF rasterizer with
+ * the float reference (sgfx_text_sdf_ref_diff) over every glyph of a
+ * synthetic SDF font, across sizes, bold, skew and outline. Exits 1 if any
+ * pixel differs by more than CHECK_MAX_DIFF.
+ *
+ * Host (run from the repo root):
+ *   cc -std=c99 -O2 -Iinclude -DSGFX_HAL_VIRTUAL examples/sdf_check/src/main.c
+ *      src/core/text/sgfx_text.c src/core/text/sgfx_font_builtin_sdf_stub.c
+ *      src/core/sgfx_fb.c src/core/sgfx_fb_fmt.c src/core/sgfx_hash.c src/core/gfx_core.c
+ *      -o sgfx_sdf_check -lm
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sgfx_text.h"
+
+#ifndef CHECK_MAX_DIFF
+#define CHECK_MAX_DIFF 4
+#endif
+
+/* SGFXF v1 records, as read by sgfx_font_load_from_memory() */
+typedef struct {
+  uint32_t magic; uint16_t version, kind, atlas_w, atlas_h;
+  int16_t ascender, descender, line_gap; uint32_t glyph_count, cmap_count;
+} font_header_t;
+typedef struct {
+  uint32_t codepoint; uint16_t gx, gy, gw, gh;
+  int16_t bearing_x, bearing_y, advance; float norm_scale;
+} font_glyph_t;
+typedef struct { uint32_t codepoint, glyph_index; } font_cmap_t;
+
+#define CELL   24
+#define NGLYPH 95   /* ASCII 32..126, 16 cells per atlas row */
+
+/* Discs and rings of varying radius and centre, 12 SDF steps per texel, so
+ * fields run smooth, saturate and have thin features. */
+static sgfx_font_t* make_font(void){
+  const int aw = 16 * CELL, ah = (NGLYPH + 15) / 16 * CELL;
+  size_t size = sizeof(font_header_t) + NGLYPH * (sizeof(font_glyph_t) + sizeof(font_cmap_t)) + (size_t)aw * ah;
+  uint8_t* blob = (uint8_t*)calloc(1, size);
+  if (!blob) return NULL;
+  font_header_t* h = (font_header_t*)blob;
+  font_glyph_t* g = (font_glyph_t*)(h + 1);
+  font_cmap_t* c = (font_cmap_t*)(g + NGLYPH);
+  uint8_t* atlas = (uint8_t*)(c + NGLYPH);
+  *h = (font_header_t){ 0x58464753u, 1, SGFX_FONT_SDF_A8, (uint16_t)aw, (uint16_t)ah, 1, 0, 0, NGLYPH, NGLYPH };
+  for (int i = 0; i < NGLYPH; ++i){
+    g[i] = (font_glyph_t){ (uint32_t)(32 + i), (uint16_t)(CELL * (i % 16)), (uint16_t)(CELL * (i / 16)),
+                           CELL, CELL, 1, 20, 22, 1.0f / 20 };
+    c[i] = (font_cmap_t){ (uint32_t)(32 + i), (uint32_t)i };
+  }
+  for (int y = 0; y < ah; ++y)
+    for (int x = 0; x < aw; ++x){
+      int i = (y / CELL) * 16 + x / CELL;
+      float cx = 12 + (i % 5) - 2, cy = 12 + (i % 3) - 1, r = 5 + (i % 6);
+      float d = r - hypotf(x % CELL + .5f - cx, y % CELL + .5f - cy);
+      if (i % 4 == 1) d = 2.5f - fabsf(d);
+      int v = 128 + (int)lrintf(d * 12.f);
+      atlas[(size_t)y * aw + x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+  sgfx_font_t* f = sgfx_font_load_from_memory(blob, size);
+  free(blob);
+  return f;
+}
+
+int main(void){
+  sgfx_font_t* f = make_font();
+  if (!f){ printf("font load failed\n"); return 1; }
+  static const float PX[] = { 6, 9, 13, 20, 27, 40 };
+  static const float BOLD[] = { 0, .3f, 1.f, -.5f };
+  static const float SKEW[] = { 0, .2f, .35f };
+  static const float OUTLINE[] = { 0, 1.5f, 1.5f };   /* last: ring only (fill_alpha 0) */
+  const int NPX = sizeof PX / sizeof PX[0], NB = sizeof BOLD / sizeof BOLD[0];
+  const int NS = sizeof SKEW / sizeof SKEW[0], NO = sizeof OUTLINE / sizeof OUTLINE[0];
+
+  int worst = 0, failed = 0;
+  for (int a = 0; a < NPX; ++a)
+    for (int b = 0; b < NB; ++b)
+      for (int s = 0; s < NS; ++s)
+        for (int o = 0; o < NO; ++o){
+          sgfx_text_style_t st = sgfx_text_style_default((sgfx_rgba8_t){255,255,255,255}, PX[a]);
+          st.bold_px = BOLD[b]; st.italic_skew = SKEW[s]; st.outline_px = OUTLINE[o];
+          if (o == NO - 1) st.fill_alpha = 0;
+          int m = 0;
+          for (int i = 0; i < NGLYPH; ++i){
+            int d = sgfx_text_sdf_ref_diff(f, (uint32_t)(32 + i), &st);
+            if (d < 0){ printf("glyph %d: no SDF raster\n", 32 + i); return 1; }
+            if (d > m) m = d;
+          }
+          if (m > worst) worst = m;
+          if (m > CHECK_MAX_DIFF){
+            failed++;
+            printf("px %.0f bold %.2f skew %.2f outline %.1f%s: max diff %d\n", PX[a], BOLD[b],
+                   SKEW[s], OUTLINE[o], st.fill_alpha ? "" : " (ring)", m);
+          }
+        }
+  printf("%d styles x %d glyphs: max diff %d/255 (limit %d)%s\n",
+         NPX * NB * NS * NO, NGLYPH, worst, CHECK_MAX_DIFF, failed ? ", FAILED" : "");
+  sgfx_font_close(f);
+  return failed ? 1 : 0;
+}
@@ -40,7 +40,10 @@ typedef enum {
   SGFX_FMT_RGB565,
   SGFX_FMT_RGB666,
   SGFX_FMT_RGB888,
-  SGFX_FMT_ARGB8888
+  SGFX_FMT_ARGB8888,
+  SGFX_FMT_GRAY4,
+  SGFX_FMT_RGB332,
+  SGFX_FMT_INDEXED8
 } sgfx_pixfmt_t;
 
 typedef struct { uint8_t r,g,b,a; } sgfx_rgba8_t;
@@ -59,7 +62,7 @@ typedef struct sgfx_device sgfx_device_t;
 /* ---------- Bus ops (HAL) ---------- */
 typedef struct {
   int  (*begin)(sgfx_bus_t*);                             /* claim bus / set CS */
-  void (*end)(sgfx_bus_t*);                               /* release bus */
+  void (*end)(sgfx_bus_t*);                               /* free HAL context (sgfx_deinit) */
   int  (*write_cmd)(sgfx_bus_t*, uint8_t cmd);            /* send one command */
   int  (*write_data)(sgfx_bus_t*, const void* buf, size_t len); /* send data bytes */
   int  (*write_repeat)(sgfx_bus_t*, const void* unit, size_t unit_bytes, size_t count);
@@ -67,8 +70,19 @@ typedef struct {
   int  (*read_data)(sgfx_bus_t*, void* buf, size_t len);  /* optional */
   void (*delay_ms)(sgfx_bus_t*, uint32_t ms);
   void (*gpio_set)(sgfx_bus_t*, int pin_id, bool level);  /* RESET/DC/BL if needed */
+  /* optional async pair: queue data bytes (DC=1) and return at once; the buffer
+   * must stay untouched until the matching wait_async() returns. FIFO order. */
+  int  (*write_data_async)(sgfx_bus_t*, const void* buf, size_t len);
+  int  (*wait_async)(sgfx_bus_t*);                        /* oldest queued transfer done */
+  /* optional: a run of commands, each  cmd, n, args[n],  in one transaction */
+  int  (*write_cmds)(sgfx_bus_t*, const uint8_t* seq, size_t len);
 } sgfx_bus_ops_t;
 
+/* sgfx_bus_t.features */
+enum {
+  SGFX_BUS_HW_RESET  = 1u<<0    /* gpio_set(RST) drives a wired reset line */
+};
+
 struct sgfx_bus {
   const sgfx_bus_ops_t* ops;
   void* user;
@@ -95,18 +109,23 @@ typedef struct {
   int  (*invert)(sgfx_device_t*, bool on);
   int  (*brightness)(sgfx_device_t*, uint8_t pct);
   int  (*present)(sgfx_device_t*);
+  void (*deinit)(sgfx_device_t*);                    /* optional: free drv_state */
+  /* optional vertical scroll: panel rows [top, top+h) show RAM row
+   * top + (i + line) % h at position i; h = 0 ends scrolling */
+  int  (*scroll)(sgfx_device_t*, int top, int h, int line);
 } sgfx_driver_ops_t;
 
 /* caps flags */
 enum {
   SGFX_CAP_PARTIAL   = 1u<<0,
   SGFX_CAP_READBACK  = 1u<<1,
-  SGFX_CAP_SCROLL    = 1u<<2,
+  SGFX_CAP_SCROLL    = 1u<<2,   /* drv->scroll (may still refuse some rotations) */
   SGFX_CAP_INVERT    = 1u<<3,
   SGFX_CAP_HW_FILL   = 1u<<4,
   SGFX_CAP_EPD       = 1u<<5,
   SGFX_CAP_RGB_IF    = 1u<<6,
-  SGFX_CAP_ROUND     = 1u<<7
+  SGFX_CAP_ROUND     = 1u<<7,
+  SGFX_CAP_RAW_STREAM= 1u<<8   /* after set_window, RGB565 goes out as plain bus data */
 };
 
 /* ---------- Device object ---------- */
@@ -119,20 +138,37 @@ struct sgfx_device {
   void*                    scratch;
   size_t                   scratch_bytes;
   sgfx_palette_t           palette;
+  uint32_t                 palette_gen; /* bumped by sgfx_set_palette */
   uint8_t                  dither;
   int                      mirror; 
+  void*                    drv_state;  /* driver-private, set up by drv->init */
 };
 
 /* ---------- Core API ---------- */
 int  sgfx_init(sgfx_device_t* dev, sgfx_bus_t* bus,
                const sgfx_driver_ops_t* drv, const sgfx_caps_t* caps,
                void* scratch_buf, size_t scratch_len);
+/* Release driver state, then the bus context via bus->ops->end (the
+ * sgfx_bus_t itself stays the caller's). Devices share nothing: two devices on separate buses
+ * may be drawn and presented from different tasks at the same time. */
+void sgfx_deinit(sgfx_device_t* dev);
 
 void sgfx_set_clip(sgfx_device_t*, sgfx_rect_t r);
 void sgfx_reset_clip(sgfx_device_t*);
 
 void sgfx_set_rotation(sgfx_device_t*, uint8_t rot);
+/* Hardware vertical scroll (see drv->scroll). SGFX_ERR_NOSUP when the driver
+ * has none or cannot scroll rows in the current rotation. */
+int  sgfx_scroll(sgfx_device_t*, int top, int h, int line);
 void sgfx_set_palette(sgfx_device_t*, const sgfx_palette_t* pal);
+/* Dithering where the present path loses precision (RGBA8888 FB -> RGB565,
+ * RGB565 -> mono on SSD1306); see sgfx_dither.h. */
+enum {
+  SGFX_DITHER_NONE = 0,
+  SGFX_DITHER_BAYER4,
+  SGFX_DITHER_BAYER8,
+  SGFX_DITHER_FS       /* Floyd–Steinberg */
+};
 void sgfx_set_dither(sgfx_device_t*, uint8_t mode);
 
 int  sgfx_clear(sgfx_device_t*, sgfx_rgba8_t color);
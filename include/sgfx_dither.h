@@ -0,0 +1,67 @@
+#pragma once
+/*
+ * sgfx_dither.h — integer dithering helpers shared by the presenter's
+ * RGBA8888 -> RGB565 conversion and the mono (SSD1306) drivers.
+ *
+ * Modes (dev->dither, see sgfx_set_dither):
+ *   SGFX_DITHER_BAYER4 / _BAYER8 : ordered, threshold from panel (x,y)
+ *   SGFX_DITHER_FS               : Floyd–Steinberg, row streaming with a
+ *                                  one-line error buffer (rows in order)
+ */
+#include "sgfx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 8x8 Bayer matrix, 0..63. Its top-left 4x4 quadrant is 4x the 4x4 matrix. */
+extern const uint8_t sgfx_bayer8[8][8];
+
+/* Threshold 0..63 for panel position (x,y). */
+static inline int sgfx_bayer(uint8_t mode, int x, int y){
+  return mode == SGFX_DITHER_BAYER4 ? sgfx_bayer8[y & 3][x & 3] : sgfx_bayer8[y & 7][x & 7];
+}
+
+/* Error diffusion state for one rect. err holds nch values per pixel: the
+ * error owed to the next row; carry/below are the 7/16 and 1/16 shares still
+ * in flight along the current row. All in 1/16 units, so the small errors
+ * of 565 quantisation (0..7) are not lost to integer division. */
+typedef struct {
+  uint8_t  mode;
+  int      x0;           /* left edge of the rect; err index = x - x0 */
+  int16_t* err;
+  int      err_cap;      /* int16 entries allocated */
+  int16_t  carry[3], below[3];
+} sgfx_dither_t;
+
+static inline void sgfx_fs_row_start(sgfx_dither_t* d){
+  d->carry[0] = d->carry[1] = d->carry[2] = 0;
+  d->below[0] = d->below[1] = d->below[2] = 0;
+}
+
+/* Channel value with the incoming error applied, clamped to 0..255. */
+static inline int sgfx_fs_in(const sgfx_dither_t* d, int nch, int ch, int i, int v){
+  int e16 = d->err[i*nch + ch] + d->carry[ch];
+  v += (e16 >= 0 ? e16 + 8 : e16 - 8) / 16;
+  return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/* Spread quantisation error e of pixel i: 7/16 right, 3/16 below-left,
+ * 5/16 below, 1/16 below-right. err[i] is overwritten with next-row data. */
+static inline void sgfx_fs_out(sgfx_dither_t* d, int nch, int ch, int i, int e){
+  d->carry[ch] = (int16_t)(e*7);
+  if (i > 0) d->err[(i-1)*nch + ch] = (int16_t)(d->err[(i-1)*nch + ch] + e*3);
+  d->err[i*nch + ch] = (int16_t)(e*5 + d->below[ch]);
+  d->below[ch] = (int16_t)e;
+}
+
+/* Luma 0..255 of an RGB565 pixel. */
+static inline int sgfx_luma565(uint16_t p){
+  int r = (p >> 11) & 0x1F, g = (p >> 5) & 0x3F, b = p & 0x1F;
+  r = (r << 3) | (r >> 2); g = (g << 2) | (g >> 4); b = (b << 3) | (b >> 2);
+  return (r*77 + g*150 + b*29) >> 8;
+}
+
+#ifdef __cplusplus
+}
+#endif
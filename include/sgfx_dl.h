@@ -0,0 +1,70 @@
+#pragma once
+/*
+ * sgfx_dl.h — display list + banded rendering (no full framebuffer)
+ *
+ * The app records fill / A8 blit / text calls into a compact display list in
+ * panel coordinates. sgfx_band_present() replays the list once per horizontal
+ * band into a small band fb (panel width x band_h) and pushes each band with
+ * sgfx_present_frame(). A 480x320 RGB565 screen in 16-row bands needs 15 KB
+ * of pixels instead of 300 KB.
+ *
+ * With hashes kept (keep_hashes=1) each band tile's hash is stored across
+ * frames (4 bytes per panel tile), so unchanged tiles are not resent.
+ */
+#include "sgfx_fb.h"
+#include "sgfx_text.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint8_t* buf;
+  size_t   len, cap;     /* bytes used / available */
+  int      owns;         /* buf was allocated by sgfx_dl_init */
+  int      overflow;     /* a record did not fit; the list is incomplete */
+  int      count;        /* records */
+} sgfx_dl_t;
+
+/* mem == NULL: allocate cap bytes. Caller memory must be pointer aligned
+ * (records hold pointers), else SGFX_ERR_INVAL. */
+int  sgfx_dl_init(sgfx_dl_t* dl, void* mem, size_t cap);
+void sgfx_dl_free(sgfx_dl_t* dl);
+void sgfx_dl_reset(sgfx_dl_t* dl);   /* start a new frame */
+
+/* Recorders; SGFX_ERR_NOMEM when the list is full (and dl->overflow is set).
+ * blit_a8 keeps the a8 pointer, text keeps the font pointer: both must stay
+ * valid until the list is replayed. Text and style are copied. */
+int  sgfx_dl_fill_rect(sgfx_dl_t* dl, int x, int y, int w, int h, sgfx_rgba8_t c);
+int  sgfx_dl_blit_a8(sgfx_dl_t* dl, int x, int y, const uint8_t* a8, int a8_pitch,
+                     int w, int h, sgfx_rgba8_t c);
+int  sgfx_dl_text(sgfx_dl_t* dl, int x, int y, const char* utf8,
+                  const sgfx_font_t* font, const sgfx_text_style_t* style);
+
+/* Draw the list into fb, whose pixel (0,0) is panel (fb->org_x, fb->org_y).
+ * Records that miss the fb's rows are skipped without drawing. */
+void sgfx_dl_replay(const sgfx_dl_t* dl, sgfx_fb_t* fb);
+
+/* --- Banded renderer ------------------------------------------------ */
+typedef struct {
+  sgfx_fb_t    fb;       /* band buffer: panel_w x band_h */
+  int          panel_h, band_h, nbands;
+  int          band_tiles;   /* tiles per (full) band */
+  uint32_t*    hashes;   /* nbands * band_tiles tile hashes, NULL: resend every band */
+  int          synced;   /* hashes describe what the panel shows */
+  sgfx_rgba8_t bg;       /* each band is cleared to this before replay */
+} sgfx_band_t;
+
+int  sgfx_band_create(sgfx_band_t* b, int panel_w, int panel_h, int band_h,
+                      int tile_w, int tile_h, int keep_hashes);
+void sgfx_band_destroy(sgfx_band_t* b);
+/* Forget the stored hashes (panel was drawn by something else). */
+static inline void sgfx_band_invalidate(sgfx_band_t* b){ b->synced = 0; }
+/* Replay dl band by band and push each band; stats accumulate in pr->stats
+ * (one frame per band). */
+int  sgfx_band_present(sgfx_band_t* b, sgfx_present_t* pr, sgfx_device_t* dev,
+                       const sgfx_dl_t* dl);
+
+#ifdef __cplusplus
+}
+#endif
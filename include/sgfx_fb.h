@@ -1,74 +1,230 @@
 #pragma once
 #include "sgfx.h"
+#include "sgfx_dither.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* --- Pixel format selection (default: RGB565) ----------------------- */
+/* --- Default pixel format (sgfx_fb_create; default: RGB565) ---------- */
 #if !defined(SGFX_COLOR_RGB565) && !defined(SGFX_COLOR_RGBA8888)
 #  define SGFX_COLOR_RGB565 1
 #endif
 
 #if defined(SGFX_COLOR_RGBA8888) && SGFX_COLOR_RGBA8888
   typedef sgfx_rgba8_t  sgfx_color_t;
+# define SGFX_FB_FMT_DEFAULT SGFX_FMT_ARGB8888
 # define SGFX_BYTESPP   4
 # define SGFX_PACK(c)   (c)
 #else
   typedef uint16_t      sgfx_color_t;
+# define SGFX_FB_FMT_DEFAULT SGFX_FMT_RGB565
 # define SGFX_BYTESPP   2
   static inline sgfx_color_t SGFX_PACK(sgfx_rgba8_t c){
     return (uint16_t)(((c.r & 0xF8)<<8) | ((c.g & 0xFC)<<3) | (c.b>>3));
   }
 #endif
 
+/* Dirty area inside one tile, inclusive fb pixel coords; valid while the tile is dirty */
+typedef struct { uint16_t x0, y0, x1, y1; } sgfx_tile_box_t;
+
+typedef struct sgfx_fb sgfx_fb_t;
+
+/* One coverage mask for sgfx_fb_blit_a8_layers: w x h alpha8 at (x, y) in
+ * drawn coordinates, blended with c. cover_only: blend only where an earlier
+ * layer of the same call painted (e.g. to keep a neighbour's fill on top). */
+typedef struct {
+  const uint8_t* a8; int pitch;
+  int x, y, w, h;
+  sgfx_rgba8_t c;
+  uint8_t cover_only;
+} sgfx_a8_layer_t;
+#define SGFX_A8_LAYERS_MAX 4
+
+/* Per-format kernels, picked once at create. Rects passed in are clipped.
+ * to565 converts w pixels of row y (byte-swapped when swap is set).
+ * fill_index writes a raw palette index (indexed formats only, else NULL). */
 typedef struct {
+  void (*fill)(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c);
+  void (*blit_a8)(sgfx_fb_t* fb, int x,int y, const uint8_t* a8,int pitch,
+                  int w,int h, sgfx_rgba8_t c);
+  void (*to565)(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap);
+  int  (*row_solid)(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* c);
+  void (*fill_index)(sgfx_fb_t* fb, int x,int y,int w,int h, int idx);
+  /* to565 with dithering (formats deeper than RGB565 only, else NULL) */
+  void (*to565_dither)(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap,
+                       sgfx_dither_t* dt);
+  /* blend n layers bottom to top into px rows [y, y+h), reading and writing
+   * each pixel once; layer rows are drawn rows (px row + dy). NULL: one
+   * blit_a8 per layer. */
+  void (*blit_layers)(sgfx_fb_t* fb, int x,int y,int w,int h, int dy,
+                      const sgfx_a8_layer_t* L, int n);
+} sgfx_fb_ops_t;
+
+/* MONO1, GRAY4, RGB332, RGB565, ARGB8888 (bytes r,g,b,a), INDEXED4 or
+ * INDEXED8; NULL otherwise. */
+const sgfx_fb_ops_t* sgfx_fb_ops_for(sgfx_pixfmt_t fmt);
+
+struct sgfx_fb {
   int w,h;               /* in pixels */
-  int stride;            /* in bytes: w * SGFX_BYTESPP */
-  uint8_t* px;           /* pixel buffer (format = sgfx_color_t) */
+  int stride;            /* in bytes per row; MONO1: per 8-row page */
+  uint8_t* px;           /* pixel buffer, layout given by fmt */
+  sgfx_pixfmt_t fmt;
+  int bpp;               /* bits per pixel */
+  const sgfx_fb_ops_t* ops;
+  uint16_t* pal565;      /* indexed formats: 256-entry RGB565 LUT, else NULL */
+  uint32_t  pal_gen;     /* dev->palette_gen the LUT was last loaded from */
   int tile_w, tile_h;
   int tiles_x, tiles_y;
   uint32_t* tile_crc;
-  uint8_t*  tile_dirty;
-} sgfx_fb_t;
+  uint32_t* tile_dirty;   /* bitset, dirty_wpr words per tile row */
+  int       dirty_wpr;    /* words per tile row in tile_dirty */
+  uint32_t* dirty_rows;   /* summary bitset: tile row has at least one dirty tile */
+  sgfx_tile_box_t* tile_box; /* per tile: union of dirty rects since last present */
+  uint32_t* tile_touched; /* 1 bit per tile: written since the last present */
+  int       hash_writes;  /* 1: writers only touch; rehash decides what is dirty */
+  int       org_x, org_y; /* panel position of px (0,0); non-zero for band buffers (MONO1: org_y % 8 == 0) */
+  /* Scroll area (sgfx_fb_set_scroll_area): rows [scroll_top, scroll_top+scroll_h)
+   * are a ring, drawn row y lives at px row scroll_top + (y - scroll_top +
+   * scroll_y) % scroll_h. Tiles, dirty state and the presenter work on px rows. */
+  int       scroll_top, scroll_h, scroll_y;
+  int       scroll_pending; /* panel scroll start not yet sent */
+};
 
+/* Framebuffer in the build's default format (SGFX_FB_FMT_DEFAULT). */
 int  sgfx_fb_create(sgfx_fb_t* fb, int w, int h, int tile_w, int tile_h);
+/* Framebuffer in any format sgfx_fb_ops_for() knows. MONO1 is page-major
+ * (SSD1306 GDDRAM layout) and rounds tile_h up to 8; GRAY4 packs even x in
+ * the high nibble and rounds tile_w up to 2 (so does INDEXED4). The presenter
+ * converts to RGB565. */
+int  sgfx_fb_create_fmt(sgfx_fb_t* fb, sgfx_pixfmt_t fmt, int w, int h, int tile_w, int tile_h);
+/* Indexed FBs: load the LUT from a palette (size 0 = 256 entries; entries past
+ * size are black). Only tiles holding a changed index are marked dirty (one
+ * pass over the pixels, early out per tile), so colour cycling is cheap.
+ * The LUT starts as the device default (0 black, 1 white); load it before
+ * drawing with rgba colours, which map to the nearest entry. Either set it
+ * here, or with sgfx_set_palette(dev, ...): sgfx_present_frame reloads it
+ * from dev->palette only after sgfx_set_palette changed that, so the last
+ * of the two calls wins. Returns the number of changed entries, or
+ * SGFX_ERR_NOSUP for non-indexed FBs. */
+int  sgfx_fb_set_palette(sgfx_fb_t* fb, const sgfx_palette_t* pal);
+/* Fill with a raw palette index (indexed FBs); the rgba writers pick the
+ * nearest LUT entry instead. */
+void sgfx_fb_fill_index_px(sgfx_fb_t* fb, int x, int y, int w, int h, int idx);
 void sgfx_fb_destroy(sgfx_fb_t* fb);
 void sgfx_fb_mark_dirty_px(sgfx_fb_t* fb, int x, int y, int w, int h);
+/* Record a write without marking it dirty (direct px writes in hashing mode). */
+void sgfx_fb_touch_px(sgfx_fb_t* fb, int x, int y, int w, int h);
+/* Re-hash the touched tiles inside the rect; changed ones become dirty.
+ * Cost is O(touched tiles), untouched tiles are skipped a word at a time. */
 void sgfx_fb_rehash_tiles(sgfx_fb_t* fb, int x, int y, int w, int h);
+/* Hashing mode: sgfx_fb_* writers (and the text engine) only touch tiles and
+ * sgfx_present_frame re-hashes them, so redrawing identical pixels sends
+ * nothing. Turning it on marks the whole fb dirty once. */
+void sgfx_fb_set_hashing(sgfx_fb_t* fb, int on);
+void sgfx_fb_clear_touched(sgfx_fb_t* fb);
+
+/* --- Dirty tile bitset ---------------------------------------------- */
+static inline int sgfx_ctz32(uint32_t v){
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(v);
+#else
+  int n = 0; while (!(v & 1u)){ v >>= 1; n++; } return n;
+#endif
+}
+static inline int sgfx_fb_tile_dirty(const sgfx_fb_t* fb, int tx, int ty){
+  return (int)((fb->tile_dirty[(size_t)ty*fb->dirty_wpr + (tx >> 5)] >> (tx & 31)) & 1u);
+}
+/* First tile row >= ty with a dirty tile, or tiles_y. */
+int  sgfx_fb_next_dirty_row(const sgfx_fb_t* fb, int ty);
+/* First tile >= tx in row ty that is dirty (dirty=1) or clean (dirty=0), or tiles_x. */
+int  sgfx_fb_next_tile(const sgfx_fb_t* fb, int ty, int tx, int dirty);
+void sgfx_fb_clear_dirty_tiles(sgfx_fb_t* fb, int tx0, int tx1, int ty0, int ty1);
 static inline int sgfx_pm2px(int pm, int size_px){ return (pm * size_px + 500) / 1000; }
 void sgfx_ui_fill_norm(sgfx_fb_t* fb, int xpm,int ypm,int wpm,int hpm, sgfx_rgba8_t c);
 
-// Pixel-space helpers (draw into RGBA8888 framebuffer)
+// Pixel-space helpers (draw into the framebuffer in its format)
 void sgfx_fb_fill_rect_px(sgfx_fb_t* fb, int x, int y, int w, int h, sgfx_rgba8_t c);
 
-typedef struct {
-  uint16_t* linebuf;
-  int       linebuf_px;
-} sgfx_present_t;
-
+/* --- Hardware-scrolled area ------------------------------------------- */
+/* Rows [top, top+h) of the fb become a ring that the panel scrolls with
+ * sgfx_scroll(), so sgfx_fb_scroll only redraws the rows it brings in. The
+ * device needs SGFX_CAP_SCROLL (probe with sgfx_scroll(dev, 0,0,0)); when
+ * sgfx_scroll says NOSUP the presenter falls back to sgfx_fb_unscroll and
+ * pushes the whole area. The area's contents are not moved:
+ * redraw it. h = 0 ends it. The sgfx_fb_* writers, dirty marking and the text
+ * engine take drawn rows; fb->ops and direct px access see px rows. */
+int  sgfx_fb_set_scroll_area(sgfx_fb_t* fb, int top, int h);
+/* Move the area's content up by n rows (n < 0: down) and clear the |n| rows
+ * scrolled in to bg; only those are dirty. */
+void sgfx_fb_scroll(sgfx_fb_t* fb, int n, sgfx_rgba8_t bg);
+/* Store the area's rows in drawn order again (scroll_y = 0) and dirty it all:
+ * software scrolling for panels that cannot scroll. */
+void sgfx_fb_unscroll(sgfx_fb_t* fb);
 
-// Optional presenter statistics (counts per present_frame call)
+// Optional presenter statistics (accumulated per present_frame call)
 typedef struct {
   uint32_t frames;       // total frames presented
   uint32_t rects_pushed; // CASET/RASET regions sent (coalesced rects)
   uint32_t pixels_sent;  // total pixels converted/sent
   uint32_t bytes_sent;   // total bytes over the bus (approx; RGB565=2*px)
   uint32_t tiles_dirty;  // tiles marked dirty this frame
+  uint32_t rects_merged; // tile-row runs folded into a rect above (windows saved)
+  uint32_t px_overdraw;  // pushed pixels outside every dirty box (merges, box unions)
+  uint32_t async_xfers;  // chunks queued with write_data_async
+  uint32_t async_waits;  // times conversion had to wait for a free buffer
+  uint32_t solid_rects;  // single-colour rects sent via driver fill_rect
+  uint32_t solid_rows;   // single-colour rows sent via bus write_repeat
+  uint32_t bytes_saved;  // pixel bytes not read/converted/copied thanks to the above
 } sgfx_present_stats_t;
 
+/* Damage merging cost model: one CASET/RASET/RAMWR sequence is worth this many
+ * pixels of payload. A dirty run in the next tile row is merged into the rect
+ * above when the clean pixels it drags along cost less than the windows saved.
+ * Set pr->window_cost_px < 0 to keep rects within one tile row. */
+#ifndef SGFX_PRESENT_WINDOW_COST_PX
+#define SGFX_PRESENT_WINDOW_COST_PX 32
+#endif
+
+/* Async present: up to this many line buffers rotate through the bus queue. */
+#ifndef SGFX_PRESENT_MAX_BUFS
+#define SGFX_PRESENT_MAX_BUFS 4
+#endif
+
+typedef struct {
+  uint16_t* linebuf;     // bufs[0]
+  int       linebuf_px;  // pixels per buffer
+  int       window_cost_px;
+  uint16_t* bufs[SGFX_PRESENT_MAX_BUFS];
+  int       nbufs;       // 0: blocking present
+  int       next, inflight;
+  sgfx_dither_t dither;  // RGBA8888 FB conversion state (dev->dither)
+  sgfx_present_stats_t stats;
+} sgfx_present_t;
+
 void sgfx_present_stats_reset(sgfx_present_stats_t* s);
 
 int  sgfx_present_init(sgfx_present_t* pr, int max_line_px);
+/* Like sgfx_present_init, with nbufs (1..SGFX_PRESENT_MAX_BUFS) line buffers:
+ * chunk N+1 is converted while chunk N is on the bus. Used when the bus has
+ * write_data_async/wait_async and the driver sets SGFX_CAP_RAW_STREAM; else
+ * sgfx_present_frame falls back to blocking writes. Chunks pack whole rows, so
+ * narrow rects go out in few large transfers. Keep buffers DMA-capable. */
+int  sgfx_present_init_async(sgfx_present_t* pr, int max_line_px, int nbufs);
 void sgfx_present_deinit(sgfx_present_t* pr);
 int  sgfx_present_frame(sgfx_present_t* pr, sgfx_device_t* dev, sgfx_fb_t* fb);
 
-/* Alpha8 → colored blend into FB (RGB565 or RGBA8888) */
+/* Alpha8 → colored blend into FB (any format; MONO1 thresholds at 50%) */
 void sgfx_fb_blit_a8(sgfx_fb_t* fb,
                      int x, int y,
                      const uint8_t* a8, int a8_pitch,
                      int w, int h,
                      sgfx_rgba8_t color);
+/* Blend up to SGFX_A8_LAYERS_MAX masks in order (layers[0] at the bottom)
+ * over the union of their rects. RGB332/RGB565/ARGB8888 touch each pixel
+ * once; other formats blit the layers one by one (a cover_only layer
+ * masked to where the layers below it have coverage). */
+void sgfx_fb_blit_a8_layers(sgfx_fb_t* fb, const sgfx_a8_layer_t* layers, int n);
 
 #ifdef __cplusplus
 }
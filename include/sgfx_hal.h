@@ -6,15 +6,23 @@
 extern "C" {
 #endif
 
+/* port picks the bus controller, so two panels can sit on separate buses;
+ * NULL is the HAL default. Arduino: SPIClass* / TwoWire*; STM32Cube:
+ * SPI_HandleTypeDef* / I2C_HandleTypeDef*; ESP-IDF: SGFX_HAL_PORT_NUM(host). */
+#define SGFX_HAL_PORT_NUM(n)   ((void*)(intptr_t)((n) + 1))
+#define SGFX_HAL_PORT_INDEX(p) ((int)(intptr_t)(p) - 1)
+
 typedef struct sgfx_hal_cfg_spi {
   int pin_sck, pin_mosi, pin_miso, pin_cs, pin_dc, pin_rst, pin_bl;
   uint32_t hz;
+  void* port;
 } sgfx_hal_cfg_spi_t;
 
 typedef struct sgfx_hal_cfg_i2c {
   int pin_sda, pin_scl, pin_rst, pin_bl;
   uint8_t addr;
   uint32_t hz;
+  void* port;
 } sgfx_hal_cfg_i2c_t;
 
 /* Factories implemented by HALs */
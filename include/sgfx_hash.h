@@ -0,0 +1,53 @@
+#pragma once
+/*
+ * sgfx_hash.h — tile hash engine used by sgfx_fb_rehash_tiles()
+ *
+ * All hashes chain: pass the previous result as `seed` (0 to start) to hash a
+ * tile row by row. Chaining is order-sensitive; it equals one contiguous hash
+ * for the CRC engines only (word32/fast64 mix in n and finalize per call, so
+ * hashes from different row splits do not compare). Pick the engine with
+ * -DSGFX_TILE_HASH=<id>:
+ *   SGFX_HASH_CRC32_BITWISE  reference CRC-32, 8 shifts per byte, no table
+ *   SGFX_HASH_CRC32          CRC-32 slice-by-8 (8 KiB const table)
+ *   SGFX_HASH_WORD32         32-bit word mix (one multiply per 4 bytes)  [default]
+ *   SGFX_HASH_FAST64         64-bit lanes folded to 32 (best on 64-bit hosts)
+ * All four are always built; the benchmark in examples/hash_bench compares them.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SGFX_HASH_CRC32_BITWISE 0
+#define SGFX_HASH_CRC32         1
+#define SGFX_HASH_WORD32        2
+#define SGFX_HASH_FAST64        3
+
+#ifndef SGFX_TILE_HASH
+#define SGFX_TILE_HASH SGFX_HASH_WORD32
+#endif
+
+typedef uint32_t (*sgfx_hash_fn)(uint32_t seed, const void* p, size_t n);
+
+uint32_t sgfx_hash_crc32_bitwise(uint32_t seed, const void* p, size_t n);
+uint32_t sgfx_hash_crc32(uint32_t seed, const void* p, size_t n);
+uint32_t sgfx_hash_word32(uint32_t seed, const void* p, size_t n);
+uint32_t sgfx_hash_fast64(uint32_t seed, const void* p, size_t n);
+
+#if   SGFX_TILE_HASH == SGFX_HASH_CRC32_BITWISE
+# define SGFX_TILE_HASH_FN sgfx_hash_crc32_bitwise
+#elif SGFX_TILE_HASH == SGFX_HASH_CRC32
+# define SGFX_TILE_HASH_FN sgfx_hash_crc32
+#elif SGFX_TILE_HASH == SGFX_HASH_WORD32
+# define SGFX_TILE_HASH_FN sgfx_hash_word32
+#elif SGFX_TILE_HASH == SGFX_HASH_FAST64
+# define SGFX_TILE_HASH_FN sgfx_hash_fast64
+#else
+# error "SGFX_TILE_HASH: unknown engine"
+#endif
+
+#ifdef __cplusplus
+}
+#endif
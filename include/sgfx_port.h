@@ -50,6 +50,16 @@
   extern const sgfx_caps_t       sgfx_st7796_caps;
 # define SGFX__DRV_OPS  (&sgfx_st7796_ops)
 # define SGFX__DRV_CAPS (&sgfx_st7796_caps)
+#elif defined(SGFX_DRV_ILI9341)
+  extern const sgfx_driver_ops_t sgfx_ili9341_ops;
+  extern const sgfx_caps_t       sgfx_ili9341_caps;
+# define SGFX__DRV_OPS  (&sgfx_ili9341_ops)
+# define SGFX__DRV_CAPS (&sgfx_ili9341_caps)
+#elif defined(SGFX_DRV_GC9A01)
+  extern const sgfx_driver_ops_t sgfx_gc9a01_ops;
+  extern const sgfx_caps_t       sgfx_gc9a01_caps;
+# define SGFX__DRV_OPS  (&sgfx_gc9a01_ops)
+# define SGFX__DRV_CAPS (&sgfx_gc9a01_caps)
 #else
 # error "Selected driver not yet wired in sgfx_port.h"
 #endif
@@ -78,7 +88,8 @@ static inline int sgfx_autoinit(sgfx_device_t* dev, void* scratch, size_t scratc
     .pin_dc   = SGFX_PIN_DC,
     .pin_rst  = SGFX_PIN_RST,
     .pin_bl   = SGFX_PIN_BL,
-    .hz       = SGFX_SPI_HZ
+    .hz       = SGFX_SPI_HZ,
+    .port     = NULL
   };
   if (sgfx_hal_make_spi(bus, &cfg) < 0) { free(bus); return -1; }
 #elif defined(SGFX_BUS_I2C)
@@ -88,7 +99,8 @@ static inline int sgfx_autoinit(sgfx_device_t* dev, void* scratch, size_t scratc
     .pin_rst = SGFX_PIN_RST,
     .pin_bl  = SGFX_PIN_BL,
     .addr    = SGFX_I2C_ADDR,
-    .hz      = SGFX_I2C_HZ
+    .hz      = SGFX_I2C_HZ,
+    .port    = NULL
   };
   if (sgfx_hal_make_i2c(bus, &cfg) < 0) { free(bus); return -1; }
 #else
@@ -19,7 +19,8 @@ typedef struct {
   float letter_spacing;
   float line_gap_px;   /* extra gap added to font line gap */
   sgfx_rgba8_t color;
-  /* style transforms (applied at sample time for SDF; bitmap uses AA scale) */
+  /* style transforms (applied at sample time for SDF; bitmap fonts scale,
+   * dilate their coverage for the outline, and ignore bold_px/italic_skew) */
   float bold_px;       /* ≥0: positive grows strokes (dilation)           */
   float outline_px;    /* ≥0: draw outline; fill kept if fill_alpha>0     */
   float italic_skew;   /* tangent of skew angle (e.g., 0.25 ≈ 14°)        */
@@ -56,6 +57,34 @@ void sgfx_text_measure_line(const char* utf8, const sgfx_font_t* font,
                             const sgfx_text_style_t* style,
                             sgfx_text_metrics_t* out);
 
+/* --- Glyph cache ----------------------------------------------------------
+ * Rasterized glyphs are cached per (font, codepoint, px, bold_px,
+ * italic_skew), SGFX_GLYPH_CACHE_N entries shared by all fonts, least
+ * recently used evicted first. sgfx_font_close() drops the font's entries.
+ * Their bitmaps are packed into one atlas of SGFX_GLYPH_ATLAS_BYTES (static)
+ * or of caller memory; a full atlas frees its least recently used shelf.
+ * Bitmap fonts at their native px without outline are drawn from the font
+ * atlas uncached. */
+typedef struct {
+  uint32_t hits, misses, evictions;
+  uint32_t shelf_evictions;   /* shelves emptied (or atlas restarts) for space */
+} sgfx_text_cache_stats_t;
+
+void sgfx_text_cache_flush(const sgfx_font_t* font);   /* NULL: every font */
+/* Copy the counters to out (may be NULL); reset != 0 zeroes them. */
+void sgfx_text_cache_stats(sgfx_text_cache_stats_t* out, int reset);
+/* Pack glyphs into mem (rows of SGFX_GLYPH_ATLAS_W bytes) instead of the
+ * static atlas; mem NULL goes back to it. Flushes the cache. mem must
+ * outlive its use. SGFX_ERR_INVAL if bytes is less than one row. */
+int  sgfx_text_cache_set_atlas(void* mem, size_t bytes);
+
+#if defined(SGFX_HAL_VIRTUAL)
+/* Host check: rasterize cp of an SDF font with the 16.16 path and the float
+ * reference at st; largest per-pixel difference (fill and outline), -1 if
+ * cp is missing or f is not an SDF font. */
+int  sgfx_text_sdf_ref_diff(const sgfx_font_t* f, uint32_t cp, const sgfx_text_style_t* st);
+#endif
+
 /* Convenience defaults */
 static inline sgfx_text_style_t sgfx_text_style_default(sgfx_rgba8_t color, float px){
   sgfx_text_style_t s = {
@@ -0,0 +1,91 @@
+#pragma once
+/*
+ * sgfx_virtual.h — host-side virtual panel + bus (build with -DSGFX_HAL_VIRTUAL)
+ *
+ * A sgfx_bus_ops_t implementation that feeds every command/data byte into an
+ * emulated controller and keeps the resulting panel RAM in memory:
+ *   - SGFX_VPANEL_ST77XX : MIPI-DCS CASET/RASET/RAMWR (ST7735/ST7789/ST7796),
+ *                          RGB565 big-endian on the wire
+ *   - SGFX_VPANEL_SSD1306: COLUMNADDR/PAGEADDR windows + GDDRAM page bytes
+ *
+ * Bus cost is counted per op so presenter/driver changes can be judged by
+ * bytes and transactions as well as by the pixels that end up in RAM.
+ * Reset the counters before each frame to get per-frame numbers.
+ */
+#include "sgfx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  SGFX_VPANEL_ST77XX = 0,
+  SGFX_VPANEL_SSD1306
+} sgfx_vpanel_kind_t;
+
+typedef struct {
+  uint32_t cmds;        /* command bytes (DC=0, or I2C control 0x00 incl. args) */
+  uint32_t data_bytes;  /* data bytes (DC=1, or I2C control 0x40) */
+  uint32_t addr_cmds;   /* CASET/RASET/COLUMNADDR/PAGEADDR sent */
+  uint32_t windows;     /* address commands that actually changed the window */
+  uint32_t ram_writes;  /* RAMWR/RAMWRC bursts (ST77xx) or data runs (SSD1306) */
+  uint32_t px_written;  /* pixels (ST77xx) or page bytes (SSD1306) landed in RAM */
+  uint32_t px_dropped;  /* data outside RAM or with no RAM write open */
+  uint32_t cs_toggles;  /* bus transactions: one chip-select assert per op call */
+  uint32_t repeats;     /* write_repeat calls */
+  uint32_t delay_ms;    /* sum of requested delays (not slept) */
+  uint32_t async_xfers; /* write_data_async transfers queued */
+  uint32_t async_overlap; /* sync ops issued while async transfers were pending */
+} sgfx_vpanel_stats_t;
+
+/* Async transfers are held until wait_async() and only then decoded, so a
+ * buffer reused too early shows up as wrong pixels in RAM. */
+#ifndef SGFX_VPANEL_ASYNC_DEPTH
+#define SGFX_VPANEL_ASYNC_DEPTH 8
+#endif
+
+typedef struct sgfx_vpanel {
+  sgfx_vpanel_kind_t kind;
+  int ram_w, ram_h;     /* controller RAM geometry (e.g. 240x320 for ST7789) */
+  uint16_t* ram565;     /* ST77xx: row-major RGB565 (host order) */
+  uint8_t*  ram1;       /* SSD1306: page-major, bit = y & 7 */
+  sgfx_vpanel_stats_t stats;
+
+  /* controller state */
+  uint8_t  cmd;         /* last command byte */
+  uint8_t  args[8];
+  int      nargs, want; /* collected / expected parameter bytes (-1: swallow) */
+  int      ramwr;       /* RAM write open */
+  int      x0, x1, y0, y1; /* address window (columns / rows or pages) */
+  int      cx, cy;      /* RAM pointer */
+  int      have_hi; uint8_t hi; /* pending first byte of an RGB565 pixel */
+  uint8_t  madctl, colmod, mem_mode;
+  uint8_t  inverted, display_on;
+  int      vs_tfa, vs_vsa, vs_ssa; /* ST77xx VSCRDEF / VSCSAD, in scan lines */
+
+  /* async queue (FIFO) */
+  struct { const uint8_t* buf; size_t len; } q[SGFX_VPANEL_ASYNC_DEPTH];
+  int      q_head, q_count;
+} sgfx_vpanel_t;
+
+int  sgfx_vpanel_create(sgfx_vpanel_t* p, sgfx_vpanel_kind_t kind, int ram_w, int ram_h);
+void sgfx_vpanel_destroy(sgfx_vpanel_t* p);
+void sgfx_vpanel_stats_reset(sgfx_vpanel_t* p);
+
+/* Bind a bus to the panel; pass the bus to sgfx_init() as usual. */
+int  sgfx_vpanel_make_bus(sgfx_bus_t* out, sgfx_vpanel_t* p);
+
+/* Read back panel RAM as RGB565 (SSD1306: lit = 0xFFFF, dark = 0x0000). */
+uint16_t sgfx_vpanel_pixel565(const sgfx_vpanel_t* p, int x, int y);
+
+/* What the glass shows at (x,y) of the RAM space: RAM with the ST77xx
+ * vertical scroll applied (MADCTL.MY reverses the scan). Same as
+ * sgfx_vpanel_pixel565 while nothing is scrolled. */
+uint16_t sgfx_vpanel_shown565(const sgfx_vpanel_t* p, int x, int y);
+
+/* Write panel RAM as binary PPM (P6) for eyeballing; returns SGFX_OK/EIO. */
+int  sgfx_vpanel_dump_ppm(const sgfx_vpanel_t* p, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,6 +4,7 @@
 // - No legacy text here. Use sgfx_text.* (preferred) or the optional helper in sgfx_font_builtin.*.
 
 #include "sgfx.h"
+#include "sgfx_dither.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -41,6 +42,14 @@ int sgfx_init(sgfx_device_t* dev, sgfx_bus_t* bus,
   return SGFX_OK;
 }
 
+void sgfx_deinit(sgfx_device_t* dev){
+  if (!dev || !dev->drv) return;
+  if (dev->drv->deinit) dev->drv->deinit(dev);
+  dev->drv_state = NULL;
+  /* bus context from sgfx_hal_make_*; the sgfx_bus_t itself stays the caller's */
+  if (dev->bus && dev->bus->ops && dev->bus->ops->end) dev->bus->ops->end(dev->bus);
+}
+
 void sgfx_set_clip(sgfx_device_t* d, sgfx_rect_t r){
   int16_t x = (int16_t)clampi(r.x, 0, d->caps.width);
   int16_t y = (int16_t)clampi(r.y, 0, d->caps.height);
@@ -57,11 +66,28 @@ void sgfx_set_rotation(sgfx_device_t* d, uint8_t rot){
   if (d->drv->set_rotation) d->drv->set_rotation(d, d->rotation);
 }
 
+int sgfx_scroll(sgfx_device_t* d, int top, int h, int line){
+  if (!d->drv->scroll) return SGFX_ERR_NOSUP;
+  if (h < 0 || top < 0 || top + h > d->caps.height) return SGFX_ERR_INVAL;
+  return d->drv->scroll(d, top, h, line);
+}
+
 void sgfx_set_palette(sgfx_device_t* d, const sgfx_palette_t* pal){
-  if (pal) d->palette = *pal;
+  if (pal){ d->palette = *pal; d->palette_gen++; }
 }
 void sgfx_set_dither(sgfx_device_t* d, uint8_t mode){ d->dither = mode; }
 
+const uint8_t sgfx_bayer8[8][8] = {
+  {  0, 32,  8, 40,  2, 34, 10, 42 },
+  { 48, 16, 56, 24, 50, 18, 58, 26 },
+  { 12, 44,  4, 36, 14, 46,  6, 38 },
+  { 60, 28, 52, 20, 62, 30, 54, 22 },
+  {  3, 35, 11, 43,  1, 33,  9, 41 },
+  { 51, 19, 59, 27, 49, 17, 57, 25 },
+  { 15, 47,  7, 39, 13, 45,  5, 37 },
+  { 63, 31, 55, 23, 61, 29, 53, 21 }
+};
+
 /* -------------------- primitives -------------------- */
 
 int sgfx_clear(sgfx_device_t* d, sgfx_rgba8_t color){
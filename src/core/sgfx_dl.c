@@ -0,0 +1,169 @@
+#include "sgfx_dl.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Records are packed back to back, each padded to pointer alignment. y0/y1 is
+ * the (conservative) row range the record can draw to, so replay can skip it
+ * for bands it does not reach. Coordinates are stored as int16. */
+enum { DL_FILL = 1, DL_BLIT_A8, DL_TEXT };
+
+typedef struct { uint16_t op, size; int16_t y0, y1; } dl_hdr_t;
+typedef struct { dl_hdr_t h; int16_t x, y, w, hh; sgfx_rgba8_t c; } dl_fill_t;
+typedef struct { dl_hdr_t h; const uint8_t* a8; int32_t pitch; int16_t x, y, w, hh; sgfx_rgba8_t c; } dl_blit_t;
+typedef struct { dl_hdr_t h; const sgfx_font_t* font; sgfx_text_style_t st; int16_t x, y; char s[]; } dl_text_t;
+
+#define DL_ALIGN(n) (((n) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+int sgfx_dl_init(sgfx_dl_t* dl, void* mem, size_t cap){
+  memset(dl, 0, sizeof(*dl));
+  if (!cap) return SGFX_ERR_INVAL;
+  /* records hold pointers and are read in place */
+  if ((uintptr_t)mem % sizeof(void*)) return SGFX_ERR_INVAL;
+  dl->buf = mem ? (uint8_t*)mem : (uint8_t*)malloc(cap);
+  if (!dl->buf) return SGFX_ERR_NOMEM;
+  dl->owns = mem == NULL;
+  dl->cap = cap;
+  return SGFX_OK;
+}
+
+void sgfx_dl_free(sgfx_dl_t* dl){
+  if (dl->owns) free(dl->buf);
+  memset(dl, 0, sizeof(*dl));
+}
+
+void sgfx_dl_reset(sgfx_dl_t* dl){
+  dl->len = 0; dl->count = 0; dl->overflow = 0;
+}
+
+static void* dl_alloc(sgfx_dl_t* dl, int op, size_t size, int y0, int y1){
+  size = DL_ALIGN(size);
+  if (size > 0xFFFFu || dl->len + size > dl->cap){ dl->overflow = 1; return NULL; }
+  dl_hdr_t* h = (dl_hdr_t*)(dl->buf + dl->len);
+  h->op = (uint16_t)op; h->size = (uint16_t)size;
+  h->y0 = (int16_t)y0;  h->y1 = (int16_t)y1;
+  dl->len += size;
+  dl->count++;
+  return h;
+}
+
+int sgfx_dl_fill_rect(sgfx_dl_t* dl, int x, int y, int w, int h, sgfx_rgba8_t c){
+  if (w <= 0 || h <= 0) return SGFX_OK;
+  dl_fill_t* r = (dl_fill_t*)dl_alloc(dl, DL_FILL, sizeof(*r), y, y + h - 1);
+  if (!r) return SGFX_ERR_NOMEM;
+  r->x = (int16_t)x; r->y = (int16_t)y; r->w = (int16_t)w; r->hh = (int16_t)h; r->c = c;
+  return SGFX_OK;
+}
+
+int sgfx_dl_blit_a8(sgfx_dl_t* dl, int x, int y, const uint8_t* a8, int a8_pitch,
+                    int w, int h, sgfx_rgba8_t c){
+  if (!a8) return SGFX_ERR_INVAL;
+  if (w <= 0 || h <= 0) return SGFX_OK;
+  dl_blit_t* r = (dl_blit_t*)dl_alloc(dl, DL_BLIT_A8, sizeof(*r), y, y + h - 1);
+  if (!r) return SGFX_ERR_NOMEM;
+  r->a8 = a8; r->pitch = a8_pitch;
+  r->x = (int16_t)x; r->y = (int16_t)y; r->w = (int16_t)w; r->hh = (int16_t)h; r->c = c;
+  return SGFX_OK;
+}
+
+int sgfx_dl_text(sgfx_dl_t* dl, int x, int y, const char* utf8,
+                 const sgfx_font_t* font, const sgfx_text_style_t* style){
+  if (!utf8 || !font || !style) return SGFX_ERR_INVAL;
+  /* rows the run can reach: glyph boxes sit within bbox_h of the baseline,
+   * plus how far the outline band and bold reach past the fill, and the
+   * shadow offset */
+  sgfx_text_metrics_t m = {0};
+  sgfx_text_measure_line(utf8, font, style, &m);
+  int pad = 2 + (int)(style->outline_px + style->bold_px + 0.99f) + abs(style->shadow_dy);
+  size_t n = strlen(utf8) + 1;
+  dl_text_t* r = (dl_text_t*)dl_alloc(dl, DL_TEXT, sizeof(*r) + n, y - m.bbox_h - pad, y + m.bbox_h + pad);
+  if (!r) return SGFX_ERR_NOMEM;
+  r->font = font; r->st = *style;
+  r->x = (int16_t)x; r->y = (int16_t)y;
+  memcpy(r->s, utf8, n);
+  return SGFX_OK;
+}
+
+void sgfx_dl_replay(const sgfx_dl_t* dl, sgfx_fb_t* fb){
+  const int ox = fb->org_x, oy = fb->org_y;
+  const int top = oy, bot = oy + fb->h - 1;
+  for (size_t off = 0; off < dl->len; ){
+    const dl_hdr_t* h = (const dl_hdr_t*)(dl->buf + off);
+    off += h->size;
+    if (h->y1 < top || h->y0 > bot) continue;
+    switch (h->op){
+      case DL_FILL: {
+        const dl_fill_t* r = (const dl_fill_t*)h;
+        sgfx_fb_fill_rect_px(fb, r->x - ox, r->y - oy, r->w, r->hh, r->c);
+      } break;
+      case DL_BLIT_A8: {
+        const dl_blit_t* r = (const dl_blit_t*)h;
+        sgfx_fb_blit_a8(fb, r->x - ox, r->y - oy, r->a8, r->pitch, r->w, r->hh, r->c);
+      } break;
+      case DL_TEXT: {
+        const dl_text_t* r = (const dl_text_t*)h;
+        sgfx_text_draw_line(fb, r->x - ox, r->y - oy, r->s, r->font, &r->st);
+      } break;
+      default: return;
+    }
+  }
+}
+
+/* --- Banded renderer ------------------------------------------------ */
+
+int sgfx_band_create(sgfx_band_t* b, int panel_w, int panel_h, int band_h,
+                     int tile_w, int tile_h, int keep_hashes){
+  memset(b, 0, sizeof(*b));
+  if (panel_h <= 0 || band_h <= 0) return SGFX_ERR_INVAL;
+  if (band_h > panel_h) band_h = panel_h;
+  int rc = sgfx_fb_create(&b->fb, panel_w, band_h, tile_w, tile_h);
+  if (rc) return rc;
+  b->panel_h = panel_h;
+  b->band_h = band_h;
+  b->nbands = (panel_h + band_h - 1) / band_h;
+  b->band_tiles = b->fb.tiles_x * b->fb.tiles_y;
+  b->bg = (sgfx_rgba8_t){0,0,0,255};
+  if (keep_hashes){
+    b->hashes = (uint32_t*)calloc((size_t)b->nbands * b->band_tiles, sizeof(uint32_t));
+    if (!b->hashes){ sgfx_fb_destroy(&b->fb); return SGFX_ERR_NOMEM; }
+  }
+  return SGFX_OK;
+}
+
+void sgfx_band_destroy(sgfx_band_t* b){
+  sgfx_fb_destroy(&b->fb);
+  free(b->hashes);
+  memset(b, 0, sizeof(*b));
+}
+
+int sgfx_band_present(sgfx_band_t* b, sgfx_present_t* pr, sgfx_device_t* dev,
+                      const sgfx_dl_t* dl){
+  if (!b || !pr || !dev || !dl) return SGFX_ERR_INVAL;
+  sgfx_fb_t* fb = &b->fb;
+  const int keep = b->hashes != NULL;
+  int rc = SGFX_OK;
+  /* In hashing mode the band's tile hashes are swapped in and out of the
+   * fb, so present_frame resends only the tiles that changed on the panel. */
+  fb->hash_writes = keep;
+  for (int i = 0; i < b->nbands && rc == SGFX_OK; ++i){
+    int y = i * b->band_h;
+    int rows = b->panel_h - y < b->band_h ? b->panel_h - y : b->band_h;
+    fb->org_y = y;
+    fb->h = rows;                       /* last band may be short */
+    fb->tiles_y = (rows + fb->tile_h - 1) / fb->tile_h;
+    size_t nt = (size_t)fb->tiles_x * fb->tiles_y;
+    uint32_t* hs = keep ? b->hashes + (size_t)i * b->band_tiles : NULL;
+    if (keep) memcpy(fb->tile_crc, hs, nt * sizeof(uint32_t));
+
+    sgfx_fb_fill_rect_px(fb, 0,0, fb->w, rows, b->bg);
+    if (keep && !b->synced) sgfx_fb_mark_dirty_px(fb, 0,0, fb->w, rows);
+    sgfx_dl_replay(dl, fb);
+    rc = sgfx_present_frame(pr, dev, fb);
+
+    if (keep) memcpy(hs, fb->tile_crc, nt * sizeof(uint32_t));
+  }
+  fb->org_y = 0;
+  fb->h = b->band_h;
+  fb->tiles_y = (b->band_h + fb->tile_h - 1) / fb->tile_h;
+  b->synced = keep && rc == SGFX_OK;
+  return rc;
+}
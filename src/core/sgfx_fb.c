@@ -1,5 +1,6 @@
 #include "sgfx_fb.h"
 #include "sgfx_text.h"
+#include "sgfx_hash.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -23,79 +24,345 @@
   #define SGFX_FB_FREE(p)    free((p))
 #endif
 
-static uint32_t crc32_u8(const uint8_t* p, size_t n){
-  uint32_t c=0xFFFFFFFFu;
-  for(size_t i=0;i<n;i++){ c ^= p[i];
-    for(int k=0;k<8;k++) c = (c>>1) ^ (0xEDB88320u & (-(int)(c&1)));
-  }
-  return ~c;
+int sgfx_fb_create(sgfx_fb_t* fb, int w, int h, int tile_w, int tile_h){
+  return sgfx_fb_create_fmt(fb, SGFX_FB_FMT_DEFAULT, w, h, tile_w, tile_h);
 }
 
-int sgfx_fb_create(sgfx_fb_t* fb, int w, int h, int tile_w, int tile_h){
+int sgfx_fb_create_fmt(sgfx_fb_t* fb, sgfx_pixfmt_t fmt, int w, int h, int tile_w, int tile_h){
   memset(fb,0,sizeof(*fb));
+  const sgfx_fb_ops_t* ops = sgfx_fb_ops_for(fmt);
+  if (!ops) return SGFX_ERR_NOSUP;
   if (w<=0 || h<=0 || tile_w<=0 || tile_h<=0) return SGFX_ERR_INVAL;
+  const int indexed = fmt == SGFX_FMT_INDEXED4 || fmt == SGFX_FMT_INDEXED8;
+  int bpp = fmt == SGFX_FMT_MONO1 ? 1 : (fmt == SGFX_FMT_GRAY4 || fmt == SGFX_FMT_INDEXED4) ? 4 :
+            (fmt == SGFX_FMT_RGB332 || fmt == SGFX_FMT_INDEXED8) ? 8 : fmt == SGFX_FMT_RGB565 ? 16 : 32;
+  /* tiles must start on a whole byte so they hash independently */
+  if (fmt == SGFX_FMT_MONO1) tile_h = (tile_h + 7) & ~7;
+  if (bpp == 4) tile_w = (tile_w + 1) & ~1;
+  fb->fmt=fmt; fb->bpp=bpp; fb->ops=ops;
   fb->w=w; fb->h=h; fb->tile_w=tile_w; fb->tile_h=tile_h;
-  fb->stride = w * (int)SGFX_BYTESPP;
-  size_t sz  = (size_t)w * (size_t)h * (size_t)SGFX_BYTESPP;
+  size_t sz;
+  if (fmt == SGFX_FMT_MONO1){
+    fb->stride = w;
+    sz = (size_t)w * (size_t)((h + 7) / 8);
+  } else {
+    fb->stride = (w * bpp + 7) / 8;
+    sz = (size_t)fb->stride * (size_t)h;
+  }
   fb->px = (uint8_t*)SGFX_FB_CALLOC(1, sz);
   if(!fb->px) return SGFX_ERR_NOMEM;
+  if (indexed){
+    fb->pal565 = (uint16_t*)calloc(256, sizeof(uint16_t));
+    if (!fb->pal565){ SGFX_FB_FREE(fb->px); memset(fb,0,sizeof(*fb)); return SGFX_ERR_NOMEM; }
+    fb->pal565[1] = 0xFFFF;   /* device default palette: black, white */
+  }
 
   fb->tiles_x = (w + tile_w - 1)/tile_w;
   fb->tiles_y = (h + tile_h - 1)/tile_h;
   size_t tiles = (size_t)fb->tiles_x * fb->tiles_y;
   fb->tile_crc  = (uint32_t*)calloc(tiles, sizeof(uint32_t));
-  fb->tile_dirty = (uint8_t*) calloc(tiles, 1);
-  if(!fb->tile_crc || !fb->tile_dirty){
-    SGFX_FB_FREE(fb->px); free(fb->tile_crc); free(fb->tile_dirty);    memset(fb,0,sizeof(*fb));
+  fb->dirty_wpr = (fb->tiles_x + 31)/32;
+  fb->tile_dirty = (uint32_t*)calloc((size_t)fb->dirty_wpr * fb->tiles_y, sizeof(uint32_t));
+  fb->dirty_rows = (uint32_t*)calloc((size_t)(fb->tiles_y + 31)/32, sizeof(uint32_t));
+  fb->tile_touched = (uint32_t*)calloc((tiles + 31)/32, sizeof(uint32_t));
+  fb->tile_box = (sgfx_tile_box_t*)calloc(tiles, sizeof(sgfx_tile_box_t));
+  if(!fb->tile_crc || !fb->tile_dirty || !fb->dirty_rows || !fb->tile_touched || !fb->tile_box){
+    SGFX_FB_FREE(fb->px); free(fb->tile_crc); free(fb->tile_dirty); free(fb->dirty_rows);
+    free(fb->tile_touched); free(fb->tile_box); free(fb->pal565);
+    memset(fb,0,sizeof(*fb));
     return SGFX_ERR_NOMEM; /* partial failure cleaned */
   }
   return SGFX_OK;
 }
 
 void sgfx_fb_destroy(sgfx_fb_t* fb){
-  SGFX_FB_FREE(fb->px); free(fb->tile_crc); free(fb->tile_dirty);
+  SGFX_FB_FREE(fb->px); free(fb->tile_crc); free(fb->tile_dirty); free(fb->dirty_rows);
+  free(fb->tile_touched); free(fb->tile_box); free(fb->pal565);
   memset(fb,0,sizeof(*fb));
 }
 
-void sgfx_fb_mark_dirty_px(sgfx_fb_t* fb, int x,int y,int w,int h){
-  if(w<=0||h<=0) return;
+/* Clip a pixel rect to the fb (in place) and return its tile range; 0 when empty. */
+static int tile_span(const sgfx_fb_t* fb, int* px,int* py,int* pw,int* ph,
+                     int* x0,int* x1,int* y0,int* y1){
+  int x=*px, y=*py, w=*pw, h=*ph;
+  if(w<=0||h<=0) return 0;
   if(x<0){ w+=x; x=0; } if(y<0){ h+=y; y=0; }
   if(x+w>fb->w) w = fb->w - x;
   if(y+h>fb->h) h = fb->h - y;
-  if(w<=0||h<=0) return;
+  if(w<=0||h<=0) return 0;
+  *px=x; *py=y; *pw=w; *ph=h;
+  *x0 = x / fb->tile_w; *x1 = (x+w-1) / fb->tile_w;
+  *y0 = y / fb->tile_h; *y1 = (y+h-1) / fb->tile_h;
+  return 1;
+}
+
+/* Set / clear bits [i0, i1] of a word bitset. */
+static void bits_set(uint32_t* b, size_t i0, size_t i1){
+  size_t w0 = i0 >> 5, w1 = i1 >> 5;
+  uint32_t m0 = ~0u << (i0 & 31), m1 = ~0u >> (31 - (i1 & 31));
+  if (w0 == w1){ b[w0] |= m0 & m1; return; }
+  b[w0] |= m0;
+  for (size_t k = w0 + 1; k < w1; ++k) b[k] = ~0u;
+  b[w1] |= m1;
+}
 
-  int x0 = x / fb->tile_w, x1 = (x+w-1) / fb->tile_w;
-  int y0 = y / fb->tile_h, y1 = (y+h-1) / fb->tile_h;
+static void bits_clear(uint32_t* b, size_t i0, size_t i1){
+  size_t w0 = i0 >> 5, w1 = i1 >> 5;
+  uint32_t m0 = ~0u << (i0 & 31), m1 = ~0u >> (31 - (i1 & 31));
+  if (w0 == w1){ b[w0] &= ~(m0 & m1); return; }
+  b[w0] &= ~m0;
+  for (size_t k = w0 + 1; k < w1; ++k) b[k] = 0;
+  b[w1] &= ~m1;
+}
+
+/* First index >= i whose bit equals `want`, or n. */
+static int bits_next(const uint32_t* b, int n, int i, int want){
+  while (i < n){
+    uint32_t w = want ? b[i >> 5] : ~b[i >> 5];
+    w &= ~0u << (i & 31);
+    if (w){ int r = (i & ~31) + sgfx_ctz32(w); return r < n ? r : n; }
+    i = (i & ~31) + 32;
+  }
+  return n;
+}
+
+int sgfx_fb_next_dirty_row(const sgfx_fb_t* fb, int ty){
+  return bits_next(fb->dirty_rows, fb->tiles_y, ty, 1);
+}
+
+int sgfx_fb_next_tile(const sgfx_fb_t* fb, int ty, int tx, int dirty){
+  return bits_next(fb->tile_dirty + (size_t)ty*fb->dirty_wpr, fb->tiles_x, tx, dirty);
+}
+
+void sgfx_fb_clear_dirty_tiles(sgfx_fb_t* fb, int tx0, int tx1, int ty0, int ty1){
+  for (int ty = ty0; ty <= ty1; ++ty){
+    uint32_t* row = fb->tile_dirty + (size_t)ty*fb->dirty_wpr;
+    bits_clear(row, (size_t)tx0, (size_t)tx1);
+    int any = 0;
+    for (int k = 0; k < fb->dirty_wpr; ++k) any |= row[k] != 0;
+    if (!any) fb->dirty_rows[ty >> 5] &= ~(1u << (ty & 31));
+  }
+}
+
+/* Grow a tile's dirty box; `fresh` means the tile was clean until now. */
+static inline void box_grow(sgfx_tile_box_t* b, int fresh, int x0,int y0,int x1,int y1){
+  if (fresh){
+    b->x0 = (uint16_t)x0; b->y0 = (uint16_t)y0; b->x1 = (uint16_t)x1; b->y1 = (uint16_t)y1;
+    return;
+  }
+  if (x0 < b->x0) b->x0 = (uint16_t)x0;
+  if (y0 < b->y0) b->y0 = (uint16_t)y0;
+  if (x1 > b->x1) b->x1 = (uint16_t)x1;
+  if (y1 > b->y1) b->y1 = (uint16_t)y1;
+}
+
+static void touch_tiles(sgfx_fb_t* fb, int x0,int x1,int y0,int y1){
   for(int ty=y0; ty<=y1; ++ty)
-    for(int tx=x0; tx<=x1; ++tx)
-      fb->tile_dirty[ty*fb->tiles_x + tx] = 1;
+    bits_set(fb->tile_touched, (size_t)ty*fb->tiles_x + x0, (size_t)ty*fb->tiles_x + x1);
 }
 
-void sgfx_fb_rehash_tiles(sgfx_fb_t* fb, int x,int y,int w,int h){
-  if(w<=0||h<=0) return;
-  if(x<0){ w+=x; x=0; } if(y<0){ h+=y; y=0; }
-  if(x+w>fb->w) w = fb->w - x;
-  if(y+h>fb->h) h = fb->h - y;
-  if(w<=0||h<=0) return;
+/* --- Scroll ring: drawn rows -> px rows ----------------------------- */
+typedef struct { int y, h, src; } row_span_t;   /* px row, rows, first drawn row - y */
+
+/* Drawn rows [y, y+h) (clipped) as px row spans: at most one above the
+ * area, two inside it (split where the ring wraps) and one below. */
+static int row_spans(const sgfx_fb_t* fb, int y, int h, row_span_t out[4]){
+  if (!fb->scroll_h){ out[0] = (row_span_t){ y, h, 0 }; return 1; }
+  const int t = fb->scroll_top, e = t + fb->scroll_h, end = y + h;
+  int n = 0;
+  for (int r = y; r < end; ){
+    int s = r, stop = r < t ? t : end;
+    if (r >= t && r < e){
+      s = t + (r - t + fb->scroll_y) % fb->scroll_h;
+      stop = r + (e - s < e - r ? e - s : e - r);
+    }
+    if (stop > end) stop = end;
+    out[n++] = (row_span_t){ s, stop - r, r - y };
+    r = stop;
+  }
+  return n;
+}
+
+static void touch_rect(sgfx_fb_t* fb, int x,int y,int w,int h){
+  int x0,x1,y0,y1;
+  if (!tile_span(fb, &x,&y,&w,&h, &x0,&x1,&y0,&y1)) return;
+  touch_tiles(fb, x0,x1,y0,y1);
+}
 
-  int x0 = x / fb->tile_w, x1 = (x+w-1) / fb->tile_w;
-  int y0 = y / fb->tile_h, y1 = (y+h-1) / fb->tile_h;
+static void dirty_rect(sgfx_fb_t* fb, int x,int y,int w,int h){
+  int x0,x1,y0,y1;
+  if (!tile_span(fb, &x,&y,&w,&h, &x0,&x1,&y0,&y1)) return;
+  touch_tiles(fb, x0,x1,y0,y1);
+  const int TW = fb->tile_w, TH = fb->tile_h;
   for(int ty=y0; ty<=y1; ++ty){
+    int by0 = ty*TH, by1 = by0 + TH - 1;
+    if (by0 < y) by0 = y;
+    if (by1 > y+h-1) by1 = y+h-1;
+    sgfx_tile_box_t* box = fb->tile_box + (size_t)ty*fb->tiles_x;
     for(int tx=x0; tx<=x1; ++tx){
-      int px = tx*fb->tile_w;
-      int py = ty*fb->tile_h;
-      int tw = (px+fb->tile_w>fb->w)? (fb->w-px): fb->tile_w;
-      int th = (py+fb->tile_h>fb->h)? (fb->h-py): fb->tile_h;
-      uint8_t* base = (uint8_t*)fb->px + (size_t)py*fb->stride + (size_t)px*SGFX_BYTESPP;
-      uint32_t crc = 0;
-      for(int j=0;j<th;++j)
-        crc ^= crc32_u8(base + (size_t)j*fb->stride, (size_t)tw*SGFX_BYTESPP);
-      size_t idx = (size_t)ty*fb->tiles_x + (size_t)tx;
-      if (crc != fb->tile_crc[idx]){ fb->tile_crc[idx]=crc; fb->tile_dirty[idx]=1; }
+      int bx0 = tx*TW, bx1 = bx0 + TW - 1;
+      if (bx0 < x) bx0 = x;
+      if (bx1 > x+w-1) bx1 = x+w-1;
+      box_grow(&box[tx], !sgfx_fb_tile_dirty(fb, tx, ty), bx0,by0,bx1,by1);
+    }
+    bits_set(fb->tile_dirty + (size_t)ty*fb->dirty_wpr, (size_t)x0, (size_t)x1);
+  }
+  bits_set(fb->dirty_rows, (size_t)y0, (size_t)y1);
+}
+
+/* Public entry points take drawn rows; clip first so spans stay in the fb. */
+static int clip_rows(const sgfx_fb_t* fb, int* y, int* h){
+  if (*y < 0){ *h += *y; *y = 0; }
+  if (*y + *h > fb->h) *h = fb->h - *y;
+  return *h > 0;
+}
+
+void sgfx_fb_touch_px(sgfx_fb_t* fb, int x,int y,int w,int h){
+  row_span_t sp[4];
+  if (!clip_rows(fb, &y, &h)) return;
+  for (int i = 0, n = row_spans(fb, y, h, sp); i < n; ++i) touch_rect(fb, x, sp[i].y, w, sp[i].h);
+}
+
+void sgfx_fb_mark_dirty_px(sgfx_fb_t* fb, int x,int y,int w,int h){
+  row_span_t sp[4];
+  if (!clip_rows(fb, &y, &h)) return;
+  for (int i = 0, n = row_spans(fb, y, h, sp); i < n; ++i) dirty_rect(fb, x, sp[i].y, w, sp[i].h);
+}
+
+/* Every fb writer ends here (px rows): in hashing mode only the hash decides dirtiness. */
+static void fb_wrote(sgfx_fb_t* fb, int x,int y,int w,int h){
+  if (fb->hash_writes) touch_rect(fb, x,y,w,h);
+  else                 dirty_rect(fb, x,y,w,h);
+}
+
+void sgfx_fb_set_hashing(sgfx_fb_t* fb, int on){
+  fb->hash_writes = on ? 1 : 0;
+  /* hashes were not kept up to date: resend everything once to resync */
+  if (on) dirty_rect(fb, 0,0, fb->w, fb->h);
+}
+
+void sgfx_fb_clear_touched(sgfx_fb_t* fb){
+  size_t tiles = (size_t)fb->tiles_x * fb->tiles_y;
+  memset(fb->tile_touched, 0, ((tiles + 31)/32) * sizeof(uint32_t));
+}
+
+/* First byte, rows (pages for MONO1) and bytes per row of a tile's pixels;
+ * tiles start on whole bytes. */
+static const uint8_t* tile_bytes(const sgfx_fb_t* fb, int px,int py,int tw,int th,
+                                 int* rows, size_t* len){
+  if (fb->fmt == SGFX_FMT_MONO1){
+    *rows = ((py + th - 1) >> 3) - (py >> 3) + 1;
+    *len = (size_t)tw;
+    return fb->px + (size_t)(py >> 3)*fb->stride + px;
+  }
+  *rows = th;
+  *len = ((size_t)tw*fb->bpp + 7)/8;
+  return fb->px + (size_t)py*fb->stride + (size_t)px*fb->bpp/8;
+}
+
+static void rehash_tile(sgfx_fb_t* fb, size_t idx){
+  int tx = (int)(idx % (size_t)fb->tiles_x), ty = (int)(idx / (size_t)fb->tiles_x);
+  int px = tx*fb->tile_w;
+  int py = ty*fb->tile_h;
+  int tw = (px+fb->tile_w>fb->w)? (fb->w-px): fb->tile_w;
+  int th = (py+fb->tile_h>fb->h)? (fb->h-py): fb->tile_h;
+  int rows; size_t len;
+  const uint8_t* base = tile_bytes(fb, px,py,tw,th, &rows, &len);
+  uint32_t crc = 0;   /* chained: rows hash as one stream, so their order counts */
+  for(int j=0;j<rows;++j)
+    crc = SGFX_TILE_HASH_FN(crc, base + (size_t)j*fb->stride, len);
+  if (crc != fb->tile_crc[idx]){
+    fb->tile_crc[idx]=crc;
+    /* hash can't say where: whole tile */
+    box_grow(&fb->tile_box[idx], !sgfx_fb_tile_dirty(fb, tx, ty), px,py, px+tw-1, py+th-1);
+    fb->tile_dirty[(size_t)ty*fb->dirty_wpr + (tx >> 5)] |= 1u << (tx & 31);
+    fb->dirty_rows[ty >> 5] |= 1u << (ty & 31);
+  }
+}
+
+/* Visits only touched tiles inside the rect (word-at-a-time skip of clean
+ * spans) and clears their touched bits. */
+static void rehash_rect(sgfx_fb_t* fb, int x,int y,int w,int h){
+  int x0,x1,y0,y1;
+  if (!tile_span(fb, &x,&y,&w,&h, &x0,&x1,&y0,&y1)) return;
+  uint32_t* b = fb->tile_touched;
+  for(int ty=y0; ty<=y1; ++ty){
+    size_t i0 = (size_t)ty*fb->tiles_x + x0, i1 = (size_t)ty*fb->tiles_x + x1;
+    for (size_t wi = i0 >> 5; wi <= (i1 >> 5); ++wi){
+      uint32_t m = b[wi];
+      if (wi == (i0 >> 5)) m &= ~0u << (i0 & 31);
+      if (wi == (i1 >> 5)) m &= ~0u >> (31 - (i1 & 31));
+      b[wi] &= ~m;
+      while (m){
+        int k = sgfx_ctz32(m);
+        m &= m - 1;
+        rehash_tile(fb, (wi << 5) + (size_t)k);
+      }
     }
   }
 }
 
+void sgfx_fb_rehash_tiles(sgfx_fb_t* fb, int x,int y,int w,int h){
+  row_span_t sp[4];
+  if (!clip_rows(fb, &y, &h)) return;
+  for (int i = 0, n = row_spans(fb, y, h, sp); i < n; ++i) rehash_rect(fb, x, sp[i].y, w, sp[i].h);
+}
+
+int sgfx_fb_set_palette(sgfx_fb_t* fb, const sgfx_palette_t* pal){
+  if (!fb->pal565) return SGFX_ERR_NOSUP;
+  if (!pal) return SGFX_ERR_INVAL;
+  const int n = pal->size ? pal->size : 256;
+  uint8_t chg[256];
+  int changed = 0;
+  for (int i=0;i<256;++i){
+    sgfx_rgba8_t c = pal->colors[i];
+    uint16_t v = i < n ? (uint16_t)(((c.r & 0xF8)<<8) | ((c.g & 0xFC)<<3) | (c.b>>3)) : 0;
+    chg[i] = v != fb->pal565[i];
+    fb->pal565[i] = v;
+    changed += chg[i];
+  }
+  if (!changed) return 0;
+
+  /* byte -> "holds a changed index": INDEXED4 packs two indices per byte */
+  uint8_t hit[256];
+  for (int b=0;b<256;++b)
+    hit[b] = fb->fmt == SGFX_FMT_INDEXED4 ? (uint8_t)(chg[b >> 4] | chg[b & 15]) : chg[b];
+  for (int ty=0; ty<fb->tiles_y; ++ty){
+    int py = ty*fb->tile_h, th = py + fb->tile_h > fb->h ? fb->h - py : fb->tile_h;
+    for (int tx=0; tx<fb->tiles_x; ++tx){
+      int px = tx*fb->tile_w, tw = px + fb->tile_w > fb->w ? fb->w - px : fb->tile_w;
+      int rows; size_t len;
+      const uint8_t* p = tile_bytes(fb, px,py,tw,th, &rows, &len);
+      int used = 0;
+      for (int j=0; j<rows && !used; ++j, p += fb->stride)
+        for (size_t i=0; i<len; ++i) if (hit[p[i]]){ used = 1; break; }
+      /* pixels did not change, so this is dirty even in hashing mode */
+      if (used) dirty_rect(fb, px,py,tw,th);
+    }
+  }
+  return changed;
+}
+
+void sgfx_fb_fill_index_px(sgfx_fb_t* fb, int x, int y, int w, int h, int idx){
+  if (!fb || !fb->px || !fb->ops->fill_index) return;
+  int x0,x1,y0,y1;
+  row_span_t sp[4];
+  if (!tile_span(fb, &x,&y,&w,&h, &x0,&x1,&y0,&y1)) return;
+  for (int i = 0, n = row_spans(fb, y, h, sp); i < n; ++i){
+    fb->ops->fill_index(fb, x, sp[i].y, w, sp[i].h, idx);
+    fb_wrote(fb, x, sp[i].y, w, sp[i].h);
+  }
+}
+
+/* Clipped rect, drawn rows. */
+static void fill_px(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c){
+  row_span_t sp[4];
+  for (int i = 0, n = row_spans(fb, y, h, sp); i < n; ++i){
+    fb->ops->fill(fb, x, sp[i].y, w, sp[i].h, c);
+    fb_wrote(fb, x, sp[i].y, w, sp[i].h);
+  }
+}
+
 void sgfx_ui_fill_norm(sgfx_fb_t* fb, int xpm,int ypm,int wpm,int hpm, sgfx_rgba8_t c){
   int x = sgfx_pm2px(xpm, fb->w);
   int y = sgfx_pm2px(ypm, fb->h);
@@ -107,11 +374,7 @@ void sgfx_ui_fill_norm(sgfx_fb_t* fb, int xpm,int ypm,int wpm,int hpm, sgfx_rgba
   if(y+h>fb->h) h = fb->h - y;
   if(w<=0||h<=0) return;
 
-  for(int j=0;j<h;++j){
-    sgfx_color_t* row = (sgfx_color_t*)((uint8_t*)fb->px + (size_t)(y+j)*fb->stride) + x;
-    for(int i=0;i<w;++i) row[i] = SGFX_PACK(c);
-  }
-  sgfx_fb_mark_dirty_px(fb, x,y,w,h);
+  fill_px(fb, x,y,w,h, c);
 }
 
 /* --- FB Pixel-space helpers (public) --- */
@@ -123,25 +386,11 @@ void sgfx_fb_fill_rect_px(sgfx_fb_t* fb, int x, int y, int w, int h, sgfx_rgba8_
   if (x + w > fb->w) w = fb->w - x;
   if (y + h > fb->h) h = fb->h - y;
   if (w<=0 || h<=0) return;
-  for (int j=0; j<h; ++j){
-    sgfx_color_t* row = (sgfx_color_t*)((uint8_t*)fb->px + (size_t)(y+j)*fb->stride) + x;
-    for (int i=0; i<w; ++i) row[i] = SGFX_PACK(c);
-  }
-  sgfx_fb_mark_dirty_px(fb, x, y, w, h);
+  fill_px(fb, x, y, w, h, c);
 }
 
 /* --- A8 → FB blend ------------------------------------------------------- */
-/* Premultiply alpha using mask and color.a, then blend into FB format.     */
-static inline uint8_t u8_mul(uint8_t a, uint8_t b){ return (uint8_t)((a*b + 128) >> 8); }
-static inline uint16_t pack565(uint8_t r,uint8_t g,uint8_t b){
-  return (uint16_t)(((r&0xF8)<<8)|((g&0xFC)<<3)|(b>>3));
-}
-static inline void unpack565(uint16_t c, uint8_t* r,uint8_t* g,uint8_t* b){
-  *r = (uint8_t)((c>>8)&0xF8); *r |= *r>>5;
-  *g = (uint8_t)((c>>3)&0xFC); *g |= *g>>6;
-  *b = (uint8_t)( c     &0x1F); *b = (*b<<3)|(*b>>2);
-}
-
+/* Effective alpha = mask * color.a; the per-format kernel blends it in.   */
 void sgfx_fb_blit_a8(sgfx_fb_t* fb, int x, int y,
                      const uint8_t* a8, int a8_pitch,
                      int w, int h, sgfx_rgba8_t color)
@@ -154,43 +403,134 @@ void sgfx_fb_blit_a8(sgfx_fb_t* fb, int x, int y,
   if (y+h > fb->h) h = fb->h - y;
   if (w<=0 || h<=0) return;
 
-  const uint8_t cr = color.r, cg = color.g, cb = color.b, ca = color.a;
-
-#if defined(SGFX_COLOR_RGBA8888) && SGFX_COLOR_RGBA8888
-  for(int j=0;j<h;++j){
-    uint8_t* dst = (uint8_t*)fb->px + (size_t)(y+j)*fb->stride + (size_t)x*4;
-    const uint8_t* src = a8 + (size_t)j*a8_pitch;
-    for(int i=0;i<w;++i){
-      uint8_t ma = src[i];
-      if(!ma){ dst+=4; continue; }
-      uint8_t a  = u8_mul(ma, ca);               /* effective alpha */
-      uint8_t ia = 255 - a;
-      /* dst= (a*color + (1-a)*dst) */
-      dst[0] = (uint8_t)((a*cb + ia*dst[0] + 127)/255);
-      dst[1] = (uint8_t)((a*cg + ia*dst[1] + 127)/255);
-      dst[2] = (uint8_t)((a*cr + ia*dst[2] + 127)/255);
-      dst[3] = (uint8_t)((a + ia*dst[3] + 127)/255);
-      dst+=4;
+  row_span_t sp[4];
+  for (int i = 0, n = row_spans(fb, y, h, sp); i < n; ++i){
+    fb->ops->blit_a8(fb, x, sp[i].y, a8 + (size_t)sp[i].src*a8_pitch, a8_pitch, w, sp[i].h, color);
+    fb_wrote(fb, x, sp[i].y, w, sp[i].h);
+  }
+}
+
+/* Fallback for cover_only layer k: blit its coverage, cleared where no
+ * layer below it has any, a row chunk at a time. */
+static void blit_cover(sgfx_fb_t* fb, const sgfx_a8_layer_t* L, int k){
+  const sgfx_a8_layer_t* c = &L[k];
+  uint8_t m[64];
+  for (int j = 0; j < c->h; ++j){
+    const int Y = c->y + j;
+    for (int x0 = 0; x0 < c->w; x0 += (int)sizeof m){
+      const int n = c->w - x0 < (int)sizeof m ? c->w - x0 : (int)sizeof m;
+      const uint8_t* src = c->a8 + (size_t)j*c->pitch + x0;
+      int any = 0;
+      for (int i = 0; i < n; ++i){
+        const int X = c->x + x0 + i;
+        int hit = 0;
+        for (int b = 0; b < k && !hit; ++b){
+          const sgfx_a8_layer_t* l = &L[b];
+          if (l->a8 && !l->cover_only && X >= l->x && X < l->x + l->w && Y >= l->y && Y < l->y + l->h)
+            hit = l->a8[(size_t)(Y - l->y)*l->pitch + (X - l->x)] != 0;
+        }
+        m[i] = hit ? src[i] : 0;
+        any |= m[i];
+      }
+      if (any) sgfx_fb_blit_a8(fb, c->x + x0, Y, m, n, n, 1, c->c);
     }
   }
-#else /* RGB565 FB */
-  for(int j=0;j<h;++j){
-    uint16_t* dst = (uint16_t*)((uint8_t*)fb->px + (size_t)(y+j)*fb->stride) + x;
-    const uint8_t* src = a8 + (size_t)j*a8_pitch;
-    for(int i=0;i<w;++i){
-      uint8_t ma = src[i];
-      if(!ma){ dst++; continue; }
-      uint8_t a  = u8_mul(ma, ca);
-      if (a == 255) { *dst++ = pack565(cr, cg, cb); continue; }
-      uint8_t ia = 255 - a;
-      uint8_t dr,dg,db; unpack565(dst[0], &dr,&dg,&db);
-      uint8_t r = (uint8_t)((a*cr + ia*dr + 127)/255);
-      uint8_t g = (uint8_t)((a*cg + ia*dg + 127)/255);
-      uint8_t b = (uint8_t)((a*cb + ia*db + 127)/255);
-      dst[0] = pack565(r,g,b);
-      dst++;
+}
+
+void sgfx_fb_blit_a8_layers(sgfx_fb_t* fb, const sgfx_a8_layer_t* L, int n){
+  if (!fb || !L || n <= 0) return;
+  if (n > SGFX_A8_LAYERS_MAX) n = SGFX_A8_LAYERS_MAX;
+  if (!fb->ops->blit_layers){
+    for (int k = 0; k < n; ++k){
+      if (!L[k].a8) continue;
+      if (L[k].cover_only) blit_cover(fb, L, k);
+      else sgfx_fb_blit_a8(fb, L[k].x, L[k].y, L[k].a8, L[k].pitch, L[k].w, L[k].h, L[k].c);
     }
+    return;
   }
-#endif
-  sgfx_fb_mark_dirty_px(fb, x,y,w,h);
+  sgfx_a8_layer_t use[SGFX_A8_LAYERS_MAX];
+  int m = 0;
+  for (int k = 0; k < n; ++k) if (L[k].a8 && L[k].w > 0 && L[k].h > 0) use[m++] = L[k];
+  if (!m) return;
+  if (m == 1){   /* a lone layer is a plain blit */
+    if (!use[0].cover_only) sgfx_fb_blit_a8(fb, use[0].x, use[0].y, use[0].a8, use[0].pitch, use[0].w, use[0].h, use[0].c);
+    return;
+  }
+  /* union of the layers, clipped */
+  int x0 = fb->w, y0 = fb->h, x1 = 0, y1 = 0;
+  for (int k = 0; k < m; ++k){
+    if (use[k].x < x0) x0 = use[k].x;
+    if (use[k].y < y0) y0 = use[k].y;
+    if (use[k].x + use[k].w > x1) x1 = use[k].x + use[k].w;
+    if (use[k].y + use[k].h > y1) y1 = use[k].y + use[k].h;
+  }
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > fb->w) x1 = fb->w;
+  if (y1 > fb->h) y1 = fb->h;
+  if (x1 <= x0 || y1 <= y0) return;
+
+  row_span_t sp[4];
+  for (int i = 0, ns = row_spans(fb, y0, y1 - y0, sp); i < ns; ++i){
+    fb->ops->blit_layers(fb, x0, sp[i].y, x1 - x0, sp[i].h, y0 + sp[i].src - sp[i].y, use, m);
+    fb_wrote(fb, x0, sp[i].y, x1 - x0, sp[i].h);
+  }
+}
+
+/* --- Hardware-scrolled area ------------------------------------------ */
+
+int sgfx_fb_set_scroll_area(sgfx_fb_t* fb, int top, int h){
+  if (!fb || top < 0 || h < 0 || top + h > fb->h) return SGFX_ERR_INVAL;
+  if (!h && !fb->scroll_h) return SGFX_OK;
+  fb->scroll_pending = 1;
+  fb->scroll_top = h ? top : 0;
+  fb->scroll_h = h;
+  fb->scroll_y = 0;
+  if (h) dirty_rect(fb, 0, top, fb->w, h);
+  return SGFX_OK;
+}
+
+/* Swap px rows a and b (MONO1: one bit of each column byte). */
+static void swap_rows(sgfx_fb_t* fb, int a, int b){
+  if (fb->fmt == SGFX_FMT_MONO1){
+    uint8_t* pa = fb->px + (size_t)(a >> 3)*fb->stride;
+    uint8_t* pb = fb->px + (size_t)(b >> 3)*fb->stride;
+    const int sa = a & 7, sb = b & 7;
+    for (int x = 0; x < fb->w; ++x){
+      int va = (pa[x] >> sa) & 1, vb = (pb[x] >> sb) & 1;
+      if (va == vb) continue;
+      pa[x] ^= (uint8_t)(1u << sa);
+      pb[x] ^= (uint8_t)(1u << sb);
+    }
+    return;
+  }
+  uint8_t* pa = fb->px + (size_t)a*fb->stride;
+  uint8_t* pb = fb->px + (size_t)b*fb->stride;
+  for (int i = 0; i < fb->stride; ++i){ uint8_t t = pa[i]; pa[i] = pb[i]; pb[i] = t; }
+}
+
+static void reverse_rows(sgfx_fb_t* fb, int a, int b){
+  for (; a < b; ++a, --b) swap_rows(fb, a, b);
+}
+
+void sgfx_fb_unscroll(sgfx_fb_t* fb){
+  const int sh = fb->scroll_h, top = fb->scroll_top, s = fb->scroll_y;
+  if (!sh) return;
+  if (s){   /* rotate the ring left by s rows: three reversals, no scratch */
+    reverse_rows(fb, top, top + s - 1);
+    reverse_rows(fb, top + s, top + sh - 1);
+    reverse_rows(fb, top, top + sh - 1);
+    fb->scroll_y = 0;
+  }
+  dirty_rect(fb, 0, top, fb->w, sh);
+}
+
+void sgfx_fb_scroll(sgfx_fb_t* fb, int n, sgfx_rgba8_t bg){
+  const int sh = fb->scroll_h, top = fb->scroll_top;
+  if (!sh || !n) return;
+  if (n >= sh || n <= -sh){ fill_px(fb, 0, top, fb->w, sh, bg); return; }
+  fb->scroll_y = ((fb->scroll_y + n) % sh + sh) % sh;
+  fb->scroll_pending = 1;
+  if (n > 0) fill_px(fb, 0, top + sh - n, fb->w, n, bg);
+  else       fill_px(fb, 0, top, fb->w, -n, bg);
 }
\ No newline at end of file
@@ -0,0 +1,413 @@
+/* Per-format framebuffer kernels.
+ *
+ * Byte-addressed formats (RGB332, RGB565, ARGB8888) define pack / mix / to565
+ * helpers and get their fill, blit_a8, blit_layers, to565 and row_solid
+ * loops stamped out by FB_DIRECT_KERNELS, so the format is resolved once per call through
+ * fb->ops and never inside a pixel loop. MONO1 (page layout), GRAY4 and the
+ * indexed formats are written out by hand. Callers pass rects already clipped.
+ */
+#include "sgfx_fb.h"
+#include <string.h>
+
+/* a*b/255 rounded; exact at the ends, so full coverage hits the opaque path */
+static inline uint8_t u8_mul(uint8_t a, uint8_t b){
+  unsigned t = (unsigned)a*b + 128u;
+  return (uint8_t)((t + (t >> 8)) >> 8);
+}
+static inline uint8_t mix8(uint8_t src, uint8_t dst, uint8_t a){
+  return (uint8_t)((a*src + (255 - a)*dst + 127) / 255);
+}
+static inline uint8_t luma8(uint8_t r, uint8_t g, uint8_t b){
+  return (uint8_t)((r*77 + g*150 + b*29) >> 8);
+}
+static inline uint16_t swap16(uint16_t v){ return (uint16_t)((v >> 8) | (v << 8)); }
+
+/* ---- RGB565 ---- */
+typedef uint16_t rgb565_px;
+static inline uint16_t rgb565_pack(sgfx_rgba8_t c){
+  return (uint16_t)(((c.r & 0xF8)<<8) | ((c.g & 0xFC)<<3) | (c.b>>3));
+}
+static inline uint16_t rgb565_565(uint16_t v){ return v; }
+static inline void rgb565_mix(uint16_t* d, uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+  uint16_t v = *d;
+  uint8_t dr = (uint8_t)((v>>8)&0xF8), dg = (uint8_t)((v>>3)&0xFC), db = (uint8_t)((v<<3)&0xF8);
+  dr |= dr>>5; dg |= dg>>6; db |= db>>5;
+  *d = (uint16_t)(((mix8(r,dr,a) & 0xF8)<<8) | ((mix8(g,dg,a) & 0xFC)<<3) | (mix8(b,db,a)>>3));
+}
+
+/* ---- RGB332 ---- */
+typedef uint8_t rgb332_px;
+static inline uint8_t rgb332_pack(sgfx_rgba8_t c){
+  return (uint8_t)((c.r & 0xE0) | ((c.g & 0xE0) >> 3) | (c.b >> 6));
+}
+static inline uint16_t rgb332_565(uint8_t v){
+  uint16_t r = (uint16_t)(v >> 5), g = (uint16_t)((v >> 2) & 7), b = (uint16_t)(v & 3);
+  return (uint16_t)((((r<<2)|(r>>1)) << 11) | (((g<<3)|g) << 5) | ((b<<3)|(b<<1)|(b>>1)));
+}
+static inline void rgb332_mix(uint8_t* d, uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+  uint8_t v = *d;
+  uint8_t dr = (uint8_t)((v & 0xE0) * 255 / 0xE0), dg = (uint8_t)(((v >> 2) & 7) * 255 / 7), db = (uint8_t)((v & 3) * 85);
+  sgfx_rgba8_t m = { mix8(r,dr,a), mix8(g,dg,a), mix8(b,db,a), 255 };
+  *d = rgb332_pack(m);
+}
+
+/* ---- ARGB8888 (stored as sgfx_rgba8_t: r,g,b,a bytes) ---- */
+typedef sgfx_rgba8_t argb8888_px;
+static inline sgfx_rgba8_t argb8888_pack(sgfx_rgba8_t c){ return c; }
+static inline uint16_t argb8888_565(sgfx_rgba8_t c){ return rgb565_pack(c); }
+static inline void argb8888_mix(sgfx_rgba8_t* d, uint8_t r, uint8_t g, uint8_t b, uint8_t a){
+  d->r = mix8(r, d->r, a);
+  d->g = mix8(g, d->g, a);
+  d->b = mix8(b, d->b, a);
+  d->a = mix8(255, d->a, a);
+}
+
+#define FB_ROW(T, fb, x, y) ((T*)((fb)->px + (size_t)(y)*(fb)->stride) + (x))
+
+/* blit_layers works on runs of up to LAYER_CHUNK pixels of a row: the run
+ * is read into a local buffer, each layer is blended into it with the same
+ * loop as blit_a8, and the touched part is written back once. */
+#define LAYER_CHUNK 64
+/* Columns [i0, i1) of the chunk at c0 (cn wide) that layer l covers on drawn
+ * row r; src is its mask indexed by chunk column. 0 if none. */
+static int layer_span(const sgfx_a8_layer_t* l, int r, int c0, int cn,
+                      const uint8_t** src, int* i0, int* i1){
+  const int lr = r - l->y;
+  if (lr < 0 || lr >= l->h) return 0;
+  const int a = l->x > c0 ? l->x : c0;
+  const int b = l->x + l->w < c0 + cn ? l->x + l->w : c0 + cn;
+  if (b <= a) return 0;
+  *src = l->a8 + (size_t)lr*l->pitch + (c0 - l->x);
+  *i0 = a - c0; *i1 = b - c0;
+  return 1;
+}
+
+#define FB_DIRECT_KERNELS(F, DITHER) \
+static void F##_fill(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c){ \
+  const F##_px v = F##_pack(c); \
+  for (int j=0;j<h;++j){ \
+    F##_px* row = FB_ROW(F##_px, fb, x, y+j); \
+    for (int i=0;i<w;++i) row[i] = v; \
+  } \
+} \
+static void F##_blit_a8(sgfx_fb_t* fb, int x,int y, const uint8_t* a8,int pitch, \
+                        int w,int h, sgfx_rgba8_t c){ \
+  const F##_px solid = F##_pack((sgfx_rgba8_t){c.r,c.g,c.b,255}); \
+  for (int j=0;j<h;++j){ \
+    F##_px* dst = FB_ROW(F##_px, fb, x, y+j); \
+    const uint8_t* src = a8 + (size_t)j*pitch; \
+    for (int i=0;i<w;++i){ \
+      uint8_t ma = src[i]; \
+      if (!ma) continue; \
+      uint8_t a = u8_mul(ma, c.a); \
+      if (a == 255) dst[i] = solid; \
+      else F##_mix(&dst[i], c.r, c.g, c.b, a); \
+    } \
+  } \
+} \
+static void F##_to565(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap){ \
+  const F##_px* src = FB_ROW(const F##_px, fb, x, y); \
+  if (swap) for (int i=0;i<w;++i) dst[i] = swap16(F##_565(src[i])); \
+  else      for (int i=0;i<w;++i) dst[i] = F##_565(src[i]); \
+} \
+static int F##_row_solid(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* c){ \
+  const F##_px* src = FB_ROW(const F##_px, fb, x, y); \
+  const uint16_t v = F##_565(src[0]); \
+  for (int i=1;i<w;++i) if (F##_565(src[i]) != v) return 0; \
+  *c = v; \
+  return 1; \
+} \
+static void F##_blit_layers(sgfx_fb_t* fb, int x,int y,int w,int h, int dy, \
+                            const sgfx_a8_layer_t* L, int n){ \
+  F##_px buf[LAYER_CHUNK]; \
+  uint8_t hit[LAYER_CHUNK]; \
+  for (int j=0;j<h;++j){ \
+    F##_px* dst = FB_ROW(F##_px, fb, 0, y+j); \
+    for (int c0=x; c0<x+w; c0+=LAYER_CHUNK){ \
+      const int cn = x + w - c0 < LAYER_CHUNK ? x + w - c0 : LAYER_CHUNK; \
+      int lo = cn, hi = 0; \
+      for (int k=0;k<n;++k){ \
+        const uint8_t* src; \
+        int i0, i1; \
+        if (!layer_span(&L[k], y + j + dy, c0, cn, &src, &i0, &i1)) continue; \
+        if (lo >= hi){ memcpy(buf, dst + c0, sizeof(F##_px)*(size_t)cn); memset(hit, 0, (size_t)cn); } \
+        const sgfx_rgba8_t c = L[k].c; \
+        const F##_px solid = F##_pack((sgfx_rgba8_t){c.r,c.g,c.b,255}); \
+        const int cover = L[k].cover_only; \
+        for (int i=i0;i<i1;++i){ \
+          uint8_t ma = src[i]; \
+          if (!ma || (cover && !hit[i])) continue; \
+          uint8_t a = u8_mul(ma, c.a); \
+          if (a == 255) buf[i] = solid; \
+          else F##_mix(&buf[i], c.r, c.g, c.b, a); \
+          hit[i] = 1; \
+        } \
+        if (i0 < lo) lo = i0; \
+        if (i1 > hi) hi = i1; \
+      } \
+      if (lo < hi) memcpy(dst + c0 + lo, buf + lo, sizeof(F##_px)*(size_t)(hi - lo)); \
+    } \
+  } \
+} \
+static const sgfx_fb_ops_t sgfx_fb_ops_##F = { F##_fill, F##_blit_a8, F##_to565, F##_row_solid, NULL, DITHER, \
+                                        F##_blit_layers };
+
+/* RGBA8888 -> RGB565 with the dither fused into the conversion loop. Bayer
+ * adds a sub-step offset before truncating (5 bit: t/8, 6 bit: t/16); FS
+ * quantises to the 565 level and diffuses the remainder. Rows of a rect must
+ * arrive top to bottom; a call at x == dt->x0 starts a new row. */
+static inline int q5(int v){ return (v << 3) | (v >> 2); }
+static inline int q6(int v){ return (v << 2) | (v >> 4); }
+
+static void argb8888_to565_dither(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap,
+                                  sgfx_dither_t* dt){
+  const sgfx_rgba8_t* src = FB_ROW(const sgfx_rgba8_t, fb, x, y);
+  const int sw = swap ? 8 : 0;
+  if (dt->mode == SGFX_DITHER_FS){
+    const int i0 = x - dt->x0;
+    if (!i0) sgfx_fs_row_start(dt);
+    for (int i=0;i<w;++i){
+      const int k = i0 + i;
+      const int vr = sgfx_fs_in(dt, 3, 0, k, src[i].r);
+      const int vg = sgfx_fs_in(dt, 3, 1, k, src[i].g);
+      const int vb = sgfx_fs_in(dt, 3, 2, k, src[i].b);
+      const int r = vr >> 3, g = vg >> 2, b = vb >> 3;
+      sgfx_fs_out(dt, 3, 0, k, vr - q5(r));
+      sgfx_fs_out(dt, 3, 1, k, vg - q6(g));
+      sgfx_fs_out(dt, 3, 2, k, vb - q5(b));
+      uint16_t v = (uint16_t)((r << 11) | (g << 5) | b);
+      dst[i] = (uint16_t)((v >> sw) | (v << sw));
+    }
+    return;
+  }
+  const int px = x + fb->org_x, py = y + fb->org_y;
+  for (int i=0;i<w;++i){
+    const int t = sgfx_bayer(dt->mode, px + i, py);
+    int r = src[i].r + (t >> 3), g = src[i].g + (t >> 4), b = src[i].b + (t >> 3);
+    if (r > 255) r = 255;
+    if (g > 255) g = 255;
+    if (b > 255) b = 255;
+    uint16_t v = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    dst[i] = (uint16_t)((v >> sw) | (v << sw));
+  }
+}
+
+FB_DIRECT_KERNELS(rgb565, NULL)
+FB_DIRECT_KERNELS(rgb332, NULL)
+FB_DIRECT_KERNELS(argb8888, argb8888_to565_dither)
+
+/* ---- GRAY4 (and INDEXED4): two pixels per byte, even x in the high nibble ---- */
+static inline uint8_t* g4_byte(const sgfx_fb_t* fb, int x, int y){
+  return fb->px + (size_t)y*fb->stride + (x >> 1);
+}
+static inline int g4_get(const uint8_t* p, int x){ return (x & 1) ? (*p & 0x0F) : (*p >> 4); }
+static inline void g4_set(uint8_t* p, int x, int v){
+  *p = (x & 1) ? (uint8_t)((*p & 0xF0) | v) : (uint8_t)((*p & 0x0F) | (v << 4));
+}
+static inline uint16_t g4_565(int v){
+  uint16_t g6 = (uint16_t)((v << 2) | (v >> 2)), g5 = (uint16_t)((v << 1) | (v >> 3));
+  return (uint16_t)((g5 << 11) | (g6 << 5) | g5);
+}
+
+static void nib_fill(sgfx_fb_t* fb, int x,int y,int w,int h, int v){
+  for (int j=0;j<h;++j){
+    uint8_t* p = g4_byte(fb, x, y+j);
+    int i = 0;
+    if (x & 1){ g4_set(p++, 1, v); i = 1; }          /* odd leading pixel */
+    int pairs = (w - i) >> 1;
+    memset(p, v * 0x11, (size_t)pairs);
+    if ((w - i) & 1) g4_set(p + pairs, 0, v);        /* trailing even pixel */
+  }
+}
+
+static void gray4_fill(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c){
+  nib_fill(fb, x,y,w,h, luma8(c.r, c.g, c.b) >> 4);
+}
+
+static void gray4_blit_a8(sgfx_fb_t* fb, int x,int y, const uint8_t* a8,int pitch,
+                          int w,int h, sgfx_rgba8_t c){
+  const uint8_t l = luma8(c.r, c.g, c.b);
+  for (int j=0;j<h;++j){
+    const uint8_t* src = a8 + (size_t)j*pitch;
+    uint8_t* row = fb->px + (size_t)(y+j)*fb->stride;
+    for (int i=0;i<w;++i){
+      uint8_t ma = src[i];
+      if (!ma) continue;
+      int px = x + i;
+      uint8_t* p = row + (px >> 1);
+      uint8_t a = u8_mul(ma, c.a);
+      g4_set(p, px, mix8(l, (uint8_t)(g4_get(p, px) * 17), a) >> 4);
+    }
+  }
+}
+
+static void gray4_to565(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap){
+  uint16_t lut[16];
+  for (int v=0; v<16; ++v) lut[v] = swap ? swap16(g4_565(v)) : g4_565(v);
+  const uint8_t* p = g4_byte(fb, x, y);
+  int i = 0;
+  if (x & 1) dst[i++] = lut[*p++ & 0x0F];
+  for (; i + 1 < w; i += 2, ++p){ dst[i] = lut[*p >> 4]; dst[i+1] = lut[*p & 0x0F]; }
+  if (i < w) dst[i] = lut[*p >> 4];
+}
+
+static int gray4_row_solid(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* c){
+  const uint8_t* row = fb->px + (size_t)y*fb->stride;
+  const int v = g4_get(row + (x >> 1), x);
+  for (int i=1;i<w;++i) if (g4_get(row + ((x+i) >> 1), x+i) != v) return 0;
+  *c = g4_565(v);
+  return 1;
+}
+
+static const sgfx_fb_ops_t sgfx_fb_ops_gray4 = { gray4_fill, gray4_blit_a8, gray4_to565, gray4_row_solid, NULL, NULL, NULL };
+
+/* ---- MONO1: SSD1306 page layout, byte = 8 rows of one column, bit = y & 7 ---- */
+static inline uint8_t* m1_byte(const sgfx_fb_t* fb, int x, int y){
+  return fb->px + (size_t)(y >> 3)*fb->stride + x;
+}
+
+static void mono1_fill(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c){
+  const int on = luma8(c.r, c.g, c.b) >= 128;
+  for (int p = y >> 3; p <= (y + h - 1) >> 3; ++p){
+    int r0 = p*8 < y ? y - p*8 : 0;
+    int r1 = p*8 + 7 > y + h - 1 ? y + h - 1 - p*8 : 7;
+    uint8_t m = (uint8_t)((0xFFu << r0) & (0xFFu >> (7 - r1)));
+    uint8_t* b = fb->px + (size_t)p*fb->stride + x;
+    if (m == 0xFF){ memset(b, on ? 0xFF : 0x00, (size_t)w); continue; }
+    if (on) for (int i=0;i<w;++i) b[i] |= m;
+    else    for (int i=0;i<w;++i) b[i] &= (uint8_t)~m;
+  }
+}
+
+/* 1 bpp has no blending: coverage >= 50% paints the colour's on/off level.
+ * Walks page by page so each fb byte is read and written once for 8 rows. */
+static void mono1_blit_a8(sgfx_fb_t* fb, int x,int y, const uint8_t* a8,int pitch,
+                          int w,int h, sgfx_rgba8_t c){
+  const int on = luma8(c.r, c.g, c.b) >= 128;
+  for (int p = y >> 3; p <= (y + h - 1) >> 3; ++p){
+    int r0 = p*8 < y ? y - p*8 : 0;
+    int r1 = p*8 + 7 > y + h - 1 ? y + h - 1 - p*8 : 7;
+    const uint8_t* src = a8 + (size_t)(p*8 + r0 - y)*pitch;
+    uint8_t* b = fb->px + (size_t)p*fb->stride + x;
+    for (int i=0;i<w;++i){
+      uint8_t m = 0;
+      const uint8_t* s = src + i;
+      for (int r=r0; r<=r1; ++r, s += pitch)
+        if (u8_mul(*s, c.a) >= 128) m |= (uint8_t)(1u << r);
+      if (on) b[i] |= m; else b[i] &= (uint8_t)~m;
+    }
+  }
+}
+
+static void mono1_to565(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap){
+  (void)swap;   /* 0x0000 / 0xFFFF read the same both ways */
+  const uint8_t* b = m1_byte(fb, x, y);
+  const int s = y & 7;
+  for (int i=0;i<w;++i) dst[i] = (uint16_t)(0u - ((b[i] >> s) & 1u));
+}
+
+static int mono1_row_solid(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* c){
+  const uint8_t* b = m1_byte(fb, x, y);
+  const uint8_t bit = (uint8_t)(1u << (y & 7)), v = b[0] & bit;
+  for (int i=1;i<w;++i) if ((b[i] & bit) != v) return 0;
+  *c = v ? 0xFFFF : 0x0000;
+  return 1;
+}
+
+static const sgfx_fb_ops_t sgfx_fb_ops_mono1 = { mono1_fill, mono1_blit_a8, mono1_to565, mono1_row_solid, NULL, NULL, NULL };
+
+/* ---- INDEXED4 / INDEXED8: palette indices, expanded through fb->pal565 ---- */
+
+/* Nearest of the first n LUT entries; resolved once per fill/blit call. */
+static int pal_nearest(const sgfx_fb_t* fb, int n, sgfx_rgba8_t c){
+  const uint16_t v = rgb565_pack(c);
+  const int r = v >> 11, g = (v >> 5) & 0x3F, b = v & 0x1F;
+  int best = 0, best_d = 0x7FFFFFFF;
+  for (int i=0;i<n;++i){
+    uint16_t e = fb->pal565[i];
+    if (e == v) return i;
+    int dr = (e >> 11) - r, dg = ((e >> 5) & 0x3F) - g, db = (e & 0x1F) - b;
+    int d = 4*dr*dr + dg*dg + 4*db*db;   /* g has one more bit */
+    if (d < best_d){ best_d = d; best = i; }
+  }
+  return best;
+}
+
+static void idx8_fill_index(sgfx_fb_t* fb, int x,int y,int w,int h, int v){
+  for (int j=0;j<h;++j) memset(FB_ROW(uint8_t, fb, x, y+j), v, (size_t)w);
+}
+static void idx8_fill(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c){
+  idx8_fill_index(fb, x,y,w,h, pal_nearest(fb, 256, c));
+}
+/* no blending between indices: coverage >= 50% paints the nearest entry */
+static void idx8_blit_a8(sgfx_fb_t* fb, int x,int y, const uint8_t* a8,int pitch,
+                         int w,int h, sgfx_rgba8_t c){
+  const uint8_t v = (uint8_t)pal_nearest(fb, 256, c);
+  for (int j=0;j<h;++j){
+    uint8_t* dst = FB_ROW(uint8_t, fb, x, y+j);
+    const uint8_t* src = a8 + (size_t)j*pitch;
+    for (int i=0;i<w;++i) if (u8_mul(src[i], c.a) >= 128) dst[i] = v;
+  }
+}
+static void idx8_to565(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap){
+  const uint8_t* src = FB_ROW(const uint8_t, fb, x, y);
+  const uint16_t* lut = fb->pal565;
+  if (swap) for (int i=0;i<w;++i) dst[i] = swap16(lut[src[i]]);
+  else      for (int i=0;i<w;++i) dst[i] = lut[src[i]];
+}
+static int idx8_row_solid(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* c){
+  const uint8_t* src = FB_ROW(const uint8_t, fb, x, y);
+  for (int i=1;i<w;++i) if (src[i] != src[0]) return 0;
+  *c = fb->pal565[src[0]];
+  return 1;
+}
+
+static const sgfx_fb_ops_t sgfx_fb_ops_idx8 = { idx8_fill, idx8_blit_a8, idx8_to565, idx8_row_solid, idx8_fill_index, NULL, NULL };
+
+static void idx4_fill(sgfx_fb_t* fb, int x,int y,int w,int h, sgfx_rgba8_t c){
+  nib_fill(fb, x,y,w,h, pal_nearest(fb, 16, c));
+}
+static void idx4_fill_index(sgfx_fb_t* fb, int x,int y,int w,int h, int v){
+  nib_fill(fb, x,y,w,h, v & 0x0F);
+}
+static void idx4_blit_a8(sgfx_fb_t* fb, int x,int y, const uint8_t* a8,int pitch,
+                         int w,int h, sgfx_rgba8_t c){
+  const int v = pal_nearest(fb, 16, c);
+  for (int j=0;j<h;++j){
+    uint8_t* row = fb->px + (size_t)(y+j)*fb->stride;
+    const uint8_t* src = a8 + (size_t)j*pitch;
+    for (int i=0;i<w;++i)
+      if (u8_mul(src[i], c.a) >= 128) g4_set(row + ((x+i) >> 1), x+i, v);
+  }
+}
+static void idx4_to565(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* dst, int swap){
+  uint16_t lut[16];
+  for (int v=0; v<16; ++v) lut[v] = swap ? swap16(fb->pal565[v]) : fb->pal565[v];
+  const uint8_t* p = g4_byte(fb, x, y);
+  int i = 0;
+  if (x & 1) dst[i++] = lut[*p++ & 0x0F];
+  for (; i + 1 < w; i += 2, ++p){ dst[i] = lut[*p >> 4]; dst[i+1] = lut[*p & 0x0F]; }
+  if (i < w) dst[i] = lut[*p >> 4];
+}
+static int idx4_row_solid(const sgfx_fb_t* fb, int x,int y,int w, uint16_t* c){
+  const uint8_t* row = fb->px + (size_t)y*fb->stride;
+  const int v = g4_get(row + (x >> 1), x);
+  for (int i=1;i<w;++i) if (g4_get(row + ((x+i) >> 1), x+i) != v) return 0;
+  *c = fb->pal565[v];
+  return 1;
+}
+
+static const sgfx_fb_ops_t sgfx_fb_ops_idx4 = { idx4_fill, idx4_blit_a8, idx4_to565, idx4_row_solid, idx4_fill_index, NULL, NULL };
+
+const sgfx_fb_ops_t* sgfx_fb_ops_for(sgfx_pixfmt_t fmt){
+  switch (fmt){
+    case SGFX_FMT_MONO1:    return &sgfx_fb_ops_mono1;
+    case SGFX_FMT_GRAY4:    return &sgfx_fb_ops_gray4;
+    case SGFX_FMT_RGB332:   return &sgfx_fb_ops_rgb332;
+    case SGFX_FMT_RGB565:   return &sgfx_fb_ops_rgb565;
+    case SGFX_FMT_ARGB8888: return &sgfx_fb_ops_argb8888;
+    case SGFX_FMT_INDEXED4: return &sgfx_fb_ops_idx4;
+    case SGFX_FMT_INDEXED8: return &sgfx_fb_ops_idx8;
+    default:                return NULL;
+  }
+}
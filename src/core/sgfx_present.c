@@ -3,93 +3,375 @@
 #include <stdlib.h>
 #include <string.h>
 
-/* Default to RGB565 framebuffer unless RGBA8888 explicitly selected */
-#if !defined(SGFX_COLOR_RGB565) && !defined(SGFX_COLOR_RGBA8888)
-#  define SGFX_COLOR_RGB565 1
-#endif
-
-static inline uint16_t rgb565_of(sgfx_rgba8_t c){
-  return (uint16_t)(((c.r & 0xF8)<<8) | ((c.g & 0xFC)<<3) | (c.b>>3));
+int sgfx_present_init(sgfx_present_t* pr, int max_line_px){
+  int rc = sgfx_present_init_async(pr, max_line_px, 1);
+  pr->nbufs = 0; /* blocking writes */
+  return rc;
 }
 
-int sgfx_present_init(sgfx_present_t* pr, int max_line_px){
+int sgfx_present_init_async(sgfx_present_t* pr, int max_line_px, int nbufs){
   memset(pr,0,sizeof(*pr));
-  if (max_line_px <= 0) return SGFX_ERR_INVAL;
-  pr->linebuf = (uint16_t*)malloc((size_t)max_line_px * sizeof(uint16_t));
+  if (max_line_px <= 0 || nbufs < 1 || nbufs > SGFX_PRESENT_MAX_BUFS) return SGFX_ERR_INVAL;
+  pr->linebuf = (uint16_t*)malloc((size_t)max_line_px * (size_t)nbufs * sizeof(uint16_t));
   if(!pr->linebuf) return SGFX_ERR_NOMEM;
+  for (int i=0;i<nbufs;++i) pr->bufs[i] = pr->linebuf + (size_t)i*max_line_px;
+  pr->nbufs = nbufs;
   pr->linebuf_px = max_line_px;
+  pr->window_cost_px = SGFX_PRESENT_WINDOW_COST_PX;
   return SGFX_OK;
 }
 
 void sgfx_present_deinit(sgfx_present_t* pr){
-  free(pr->linebuf); memset(pr,0,sizeof(*pr));
+  free(pr->linebuf); free(pr->dither.err); memset(pr,0,sizeof(*pr));
 }
 
-static void push_rect(sgfx_present_t* pr, sgfx_device_t* d,
-                      sgfx_fb_t* fb, int x,int y,int w,int h){
+#ifdef SGFX_RGB565_BYTESWAP
+#  define WIRE_SWAP 1
+#else
+#  define WIRE_SWAP 0
+#endif
+
+static inline uint16_t wire565(uint16_t v){
+  return WIRE_SWAP ? (uint16_t)((v >> 8) | (v << 8)) : v;
+}
+
+/* RGB565 fb rows already are what write_pixels takes: no conversion */
+static inline int fb_native(const sgfx_fb_t* fb){ return fb->fmt == SGFX_FMT_RGB565; }
+
+static inline const uint16_t* fb_row565(const sgfx_fb_t* fb, int x, int y){
+  return (const uint16_t*)(fb->px + (size_t)y*fb->stride) + x;
+}
+
+/* ---- conversion (dithered when dev->dither is set and the FB is deeper than 565) ---- */
+
+static inline int fb_dithers(const sgfx_device_t* d, const sgfx_fb_t* fb){
+  return d->dither && fb->ops->to565_dither;
+}
+
+/* Arm the dither for a rect starting at x; FS needs 3 errors per pixel. */
+static void dither_begin(sgfx_present_t* pr, const sgfx_device_t* d, const sgfx_fb_t* fb, int x, int w){
+  sgfx_dither_t* dt = &pr->dither;
+  dt->mode = fb_dithers(d, fb) ? d->dither : SGFX_DITHER_NONE;
+  dt->x0 = x;
+  if (dt->mode != SGFX_DITHER_FS) return;
+  if (dt->err_cap < 3*w){
+    int16_t* e = (int16_t*)realloc(dt->err, (size_t)3*w*sizeof(int16_t));
+    if (!e){ dt->mode = SGFX_DITHER_BAYER8; return; }   /* no RAM: ordered instead */
+    dt->err = e; dt->err_cap = 3*w;
+  }
+  memset(dt->err, 0, (size_t)3*w*sizeof(int16_t));
+}
+
+static inline void convert(sgfx_present_t* pr, const sgfx_fb_t* fb, int x, int y, int w,
+                           uint16_t* dst, int swap){
+  if (pr->dither.mode) fb->ops->to565_dither(fb, x, y, w, dst, swap, &pr->dither);
+  else                 fb->ops->to565(fb, x, y, w, dst, swap);
+}
+
+/* ---- solid colour detection ---- */
+
+/* Leading rows of the rect that are all one colour; h means the rect is solid. */
+static int solid_lead(const sgfx_fb_t* fb, int x,int y,int w,int h, uint16_t* c){
+  uint16_t first, v;
+  if (!fb->ops->row_solid(fb, x, y, w, &first)) return 0;
+  int j = 1;
+  while (j < h && fb->ops->row_solid(fb, x, y+j, w, &v) && v == first) j++;
+  *c = first;
+  return j;
+}
+
+static inline sgfx_rgba8_t rgba_of565(uint16_t v){
+  uint8_t r = (uint8_t)((v >> 11) & 0x1F), g = (uint8_t)((v >> 5) & 0x3F), b = (uint8_t)(v & 0x1F);
+  sgfx_rgba8_t c = { (uint8_t)((r<<3)|(r>>2)), (uint8_t)((g<<2)|(g>>4)), (uint8_t)((b<<3)|(b>>2)), 255 };
+  return c;
+}
+
+/* 1 bpp page panel (SSD1306 layout). bpp is checked too: MONO1 is enum 0,
+ * so caps that leave native_fmt unset would otherwise read as MONO1. */
+static inline int panel_pages(const sgfx_device_t* d){
+  return d->caps.bpp == 1 && d->caps.native_fmt == SGFX_FMT_MONO1;
+}
+
+/* Dithered pixels must each go through conversion: no solid shortcuts then,
+ * whether the presenter dithers or a mono panel does. */
+static inline int solid_ok(const sgfx_device_t* d, const sgfx_fb_t* fb){
+  return !d->dither || (!fb_dithers(d, fb) && !panel_pages(d));
+}
+
+/* Solid rows can go out as a bus repeat only if the driver streams raw data. */
+static inline int can_repeat(const sgfx_device_t* d, const sgfx_fb_t* fb){
+  return (d->caps.caps & SGFX_CAP_RAW_STREAM) && d->bus->ops->write_repeat && solid_ok(d, fb);
+}
+
+static void push_repeat(sgfx_present_t* pr, sgfx_device_t* d, uint16_t c, int rows, int w){
+  uint16_t unit = wire565(c);
+  size_t n = (size_t)rows * (size_t)w;
+  d->bus->ops->write_repeat(d->bus, &unit, sizeof(unit), n);
+  pr->stats.solid_rows  += (uint32_t)rows;
+  pr->stats.bytes_saved += (uint32_t)(n * 2u - sizeof(unit));
+}
+
+/* ---- blocking path ---- */
+
+static void push_row(sgfx_present_t* pr, sgfx_device_t* d, const sgfx_fb_t* fb, int x, int y, int w){
   int maxw = pr->linebuf_px;
-  d->drv->set_window(d, x,y,w,h);
-  for(int j=0;j<h;++j){
-    #if defined(SGFX_COLOR_RGBA8888) && SGFX_COLOR_RGBA8888
-      /* RGBA8888 framebuffer: convert each chunk into linebuf (RGB565) */
-      const sgfx_rgba8_t* src = (const sgfx_rgba8_t*)((const uint8_t*)fb->px + (size_t)(y+j)*fb->stride) + x;
-      int remaining = w, col = 0;
-      while (remaining > 0){
-        int chunk = remaining > maxw ? maxw : remaining;
-        for(int i=0;i<chunk;++i) pr->linebuf[i] = rgb565_of(src[col+i]);
-        d->drv->write_pixels(d, pr->linebuf, (size_t)chunk, SGFX_FMT_RGB565);
-        remaining -= chunk;
-        col += chunk;
-      }
-    #else
-      /* RGB565 framebuffer: push rows directly (no conversion) */
-      const uint16_t* src565 = (const uint16_t*)((const uint8_t*)fb->px + (size_t)(y+j)*fb->stride) + x;
-      int remaining = w, col = 0;
-      while (remaining > 0){
-        int chunk = remaining > maxw ? maxw : remaining;
-        d->drv->write_pixels(d, src565 + col, (size_t)chunk, SGFX_FMT_RGB565);
-        remaining -= chunk;
-        col += chunk;
+  int remaining = w, col = 0;
+  while (remaining > 0){
+    int chunk = remaining > maxw ? maxw : remaining;
+    if (fb_native(fb)){
+      d->drv->write_pixels(d, fb_row565(fb, x + col, y), (size_t)chunk, SGFX_FMT_RGB565);
+    } else {
+      /* other formats: convert each chunk into linebuf (RGB565) */
+      convert(pr, fb, x + col, y, chunk, pr->linebuf, 0);
+      d->drv->write_pixels(d, pr->linebuf, (size_t)chunk, SGFX_FMT_RGB565);
+    }
+    remaining -= chunk;
+    col += chunk;
+  }
+}
+
+/* The first `lead` rows are known to be colour lead_c. */
+static void push_rect(sgfx_present_t* pr, sgfx_device_t* d,
+                      sgfx_fb_t* fb, int x,int y,int w,int h,
+                      int lead, uint16_t lead_c){
+  const int rep = can_repeat(d, fb);
+  d->drv->set_window(d, x + fb->org_x, y + fb->org_y, w,h);
+  uint16_t run_c = lead_c;
+  int run = rep ? lead : 0;
+  for(int j=run;j<h;++j){
+    uint16_t c = 0;
+    if (rep && fb->ops->row_solid(fb, x, y+j, w, &c)){
+      if (run && c != run_c){ push_repeat(pr, d, run_c, run, w); run = 0; }
+      run_c = c; run++;
+      continue;
+    }
+    if (run){ push_repeat(pr, d, run_c, run, w); run = 0; }
+    push_row(pr, d, fb, x, y+j, w);
+  }
+  if (run) push_repeat(pr, d, run_c, run, w);
+}
+
+/* ---- MONO1 fb on a 1 bpp page panel: page bytes go out as stored ---- */
+
+static inline int fb_pages(const sgfx_device_t* d, const sgfx_fb_t* fb){
+  return fb->fmt == SGFX_FMT_MONO1 && panel_pages(d);
+}
+
+/* y and h are page aligned; one window, then each page's columns. */
+static void push_pages(sgfx_device_t* d, const sgfx_fb_t* fb, int x,int y,int w,int h){
+  d->drv->set_window(d, x + fb->org_x, y + fb->org_y, w,h);
+  for (int p = y >> 3; p < (y + h) >> 3; ++p)
+    d->drv->write_pixels(d, fb->px + (size_t)p*fb->stride + x, (size_t)w, SGFX_FMT_MONO1);
+}
+
+/* ---- async path: ring of line buffers queued on the bus ---- */
+
+static inline int async_ok(const sgfx_present_t* pr, const sgfx_device_t* d){
+  return pr->nbufs > 0 && (d->caps.caps & SGFX_CAP_RAW_STREAM) &&
+         d->bus->ops->write_data_async && d->bus->ops->wait_async;
+}
+
+/* Free a queue slot; the buffer returned is the one the oldest transfer used. */
+static uint16_t* async_acquire(sgfx_present_t* pr, sgfx_bus_t* bus){
+  if (pr->inflight >= pr->nbufs){
+    bus->ops->wait_async(bus);
+    pr->inflight--;
+    pr->stats.async_waits++;
+  }
+  uint16_t* b = pr->bufs[pr->next];
+  pr->next = (pr->next + 1) % pr->nbufs;
+  return b;
+}
+
+static int async_submit(sgfx_present_t* pr, sgfx_bus_t* bus, const void* buf, size_t bytes){
+  int rc = bus->ops->write_data_async(bus, buf, bytes);
+  if (rc) return rc;
+  pr->inflight++;
+  pr->stats.async_xfers++;
+  return SGFX_OK;
+}
+
+static void async_drain(sgfx_present_t* pr, sgfx_bus_t* bus){
+  while (pr->inflight){ bus->ops->wait_async(bus); pr->inflight--; }
+}
+
+/* Queue rows [j0,j1) of the rect; short rows are packed into one buffer. */
+static int async_rows(sgfx_present_t* pr, sgfx_bus_t* bus,
+                      const sgfx_fb_t* fb, int x,int y,int w, int j0,int j1){
+  if (!fb_native(fb) || WIRE_SWAP){
+    const int maxw = pr->linebuf_px;
+    int j = j0, col = 0;
+    while (j < j1){
+      uint16_t* dst = async_acquire(pr, bus);
+      int n = 0;
+      while (n < maxw && j < j1){
+        int take = w - col; if (take > maxw - n) take = maxw - n;
+        convert(pr, fb, x + col, y + j, take, dst + n, WIRE_SWAP);
+        n += take; col += take;
+        if (col == w){ col = 0; j++; }
       }
-    #endif
+      int rc = async_submit(pr, bus, dst, (size_t)n * 2u);
+      if (rc) return rc;
+    }
+    return SGFX_OK;
+  }
+  /* no conversion: queue fb memory itself; full-width spans are one block */
+  const uint8_t* base = (const uint8_t*)fb_row565(fb, x, y + j0);
+  int rows = j1 - j0, bytes_per = w * 2;
+  if (x == 0 && w == fb->w && fb->stride == bytes_per){ bytes_per *= rows; rows = 1; }
+  for (int j=0;j<rows;++j){
+    async_acquire(pr, bus);
+    int rc = async_submit(pr, bus, base + (size_t)j*fb->stride, (size_t)bytes_per);
+    if (rc) return rc;
+  }
+  return SGFX_OK;
+}
+
+static int push_rect_async(sgfx_present_t* pr, sgfx_device_t* d,
+                           sgfx_fb_t* fb, int x,int y,int w,int h,
+                           int lead, uint16_t lead_c){
+  sgfx_bus_t* bus = d->bus;
+  const int rep = can_repeat(d, fb);
+  async_drain(pr, bus);               /* commands must not overtake pixel data */
+  d->drv->set_window(d, x + fb->org_x, y + fb->org_y, w,h);
+  uint16_t run_c = lead_c;
+  int run = rep ? lead : 0;
+  int lit = run;                      /* first row not yet queued */
+  for (int j=run;j<=h;++j){
+    uint16_t c = 0;
+    int solid = j < h && rep && fb->ops->row_solid(fb, x, y+j, w, &c);
+    if (solid && !run && lit < j){
+      int rc = async_rows(pr, bus, fb, x, y, w, lit, j);
+      if (rc) return rc;
+    }
+    if (run && (!solid || c != run_c)){
+      async_drain(pr, bus);           /* repeat is a blocking op */
+      push_repeat(pr, d, run_c, run, w);
+      run = 0; lit = j;
+    }
+    if (solid){ run_c = c; run++; lit = j + 1; }
   }
+  if (lit < h) return async_rows(pr, bus, fb, x, y, w, lit, h);
+  return SGFX_OK;
 }
 
-static sgfx_present_stats_t g_sgfx_stats;
 void sgfx_present_stats_reset(sgfx_present_stats_t* s){
   if (!s) return;
-  s->frames = s->rects_pushed = s->pixels_sent = s->bytes_sent = s->tiles_dirty = 0;
+  memset(s, 0, sizeof(*s));
 }
+
+/* Decide whether tile row `ty` joins the rect spanning tiles [x0,x1] above it.
+ * Runs fully inside the span each save one window; a run sticking out on both
+ * sides costs one extra (it is split in two). Returns the number of dirty tiles
+ * taken over, or 0 when merging does not pay off. */
+static int merge_gain(const sgfx_present_t* pr, const sgfx_fb_t* fb,
+                      int ty, int x0, int x1, int* out_saved){
+  int dirty = 0, saved = 0;
+  int tx = x0;
+  if (sgfx_fb_tile_dirty(fb, tx, ty))            /* start of a run entering from the left */
+    while (tx > 0 && sgfx_fb_tile_dirty(fb, tx-1, ty)) tx--;
+  while (tx <= x1){
+    tx = sgfx_fb_next_tile(fb, ty, tx, 1);
+    if (tx > x1) break;
+    int a = tx;
+    tx = sgfx_fb_next_tile(fb, ty, tx, 0);
+    int b = tx - 1;
+    int ia = a < x0 ? x0 : a, ib = b > x1 ? x1 : b;
+    dirty += ib - ia + 1;
+    if (a >= x0 && b <= x1) saved++;
+    else if (a < x0 && b > x1) saved--;
+  }
+  *out_saved = saved;
+  if (!dirty || saved <= 0) return 0;
+  int clean_px = ((x1 - x0 + 1) - dirty) * fb->tile_w * fb->tile_h;
+  if (clean_px > saved * pr->window_cost_px) return 0;
+  return dirty;
+}
+
 int sgfx_present_frame(sgfx_present_t* pr, sgfx_device_t* d, sgfx_fb_t* fb){
   if (!d || !d->drv || !d->drv->set_window || !d->drv->write_pixels) return SGFX_ERR_NOSUP;
   const int TX = fb->tiles_x, TY = fb->tiles_y;
-  const int TW = fb->tile_w,  TH = fb->tile_h;
+  sgfx_present_stats_t* st = &pr->stats;
+  const int async = async_ok(pr, d);
 
-  g_sgfx_stats.frames++;
-for(int ty=0; ty<TY; ++ty){
+  st->frames++;
+  /* px rows go to panel rows as stored; the panel's scroll start undoes the ring */
+  if (fb->scroll_pending){
+    int rc = sgfx_scroll(d, fb->scroll_h ? fb->org_y + fb->scroll_top : 0, fb->scroll_h, fb->scroll_y);
+    /* no scroll in this driver or rotation: push the area in drawn order */
+    if (rc == SGFX_ERR_NOSUP){ sgfx_fb_unscroll(fb); rc = SGFX_OK; }
+    if (rc) return rc;
+    fb->scroll_pending = 0;
+  }
+  /* follow dev->palette only when it changed, so a LUT loaded on the fb stays */
+  if (fb->pal565 && fb->pal_gen != d->palette_gen){
+    sgfx_fb_set_palette(fb, &d->palette);   /* dirties tiles using changed entries */
+    fb->pal_gen = d->palette_gen;
+  }
+  if (fb->hash_writes) sgfx_fb_rehash_tiles(fb, 0,0, fb->w, fb->h);
+  /* clean rows are skipped via the row summary, runs are found with ctz */
+  for(int ty=sgfx_fb_next_dirty_row(fb, 0); ty<TY; ty=sgfx_fb_next_dirty_row(fb, ty+1)){
     int tx=0;
-    while(tx<TX){
-      while(tx<TX && !fb->tile_dirty[ty*TX+tx]) tx++;
-      if(tx>=TX) break;
+    while((tx = sgfx_fb_next_tile(fb, ty, tx, 1)) < TX){
       int run_start = tx;
-      while(tx<TX && fb->tile_dirty[ty*TX+tx]) tx++;
+      tx = sgfx_fb_next_tile(fb, ty, tx, 0);
       int run_end = tx-1;
 
-      int x = run_start*TW;
-      int y = ty*TH;
-      int w = (run_end - run_start + 1)*TW;
-      if (x+w > fb->w) w = fb->w - x;
-      int h = TH; if (y+h > fb->h) h = fb->h - y;
+      /* grow the run down into a rectangle while the cost model agrees */
+      int ty_end = ty, tiles = run_end - run_start + 1;
+      if (pr->window_cost_px >= 0){
+        while (ty_end + 1 < TY){
+          int saved = 0;
+          int got = merge_gain(pr, fb, ty_end + 1, run_start, run_end, &saved);
+          if (!got) break;
+          ty_end++;
+          tiles += got;
+          st->rects_merged += (uint32_t)saved;
+        }
+      }
+
+      /* push only the union of the dirty boxes */
+      int bx0 = fb->w, by0 = fb->h, bx1 = -1, by1 = -1;
+      uint32_t box_px = 0;
+      for(int j=ty; j<=ty_end; ++j)
+        for(int k=sgfx_fb_next_tile(fb, j, run_start, 1); k<=run_end; k=sgfx_fb_next_tile(fb, j, k+1, 1)){
+          const sgfx_tile_box_t* b = &fb->tile_box[(size_t)j*TX + k];
+          if (b->x0 < bx0) bx0 = b->x0;
+          if (b->y0 < by0) by0 = b->y0;
+          if (b->x1 > bx1) bx1 = b->x1;
+          if (b->y1 > by1) by1 = b->y1;
+          box_px += (uint32_t)(b->x1 - b->x0 + 1) * (uint32_t)(b->y1 - b->y0 + 1);
+        }
+      sgfx_fb_clear_dirty_tiles(fb, run_start, run_end, ty, ty_end);
+      int x = bx0, y = by0, w = bx1 - bx0 + 1, h = by1 - by0 + 1;
+      const int pages = fb_pages(d, fb);
+      if (pages){ y = by0 & ~7; h = (by1 | 7) + 1 - y; }   /* tile rows are page aligned */
 
-      // stats: tiles in this horizontal run
-for(int k=run_start; k<=run_end; ++k) g_sgfx_stats.tiles_dirty++;
-g_sgfx_stats.rects_pushed++;
-g_sgfx_stats.pixels_sent += (uint32_t)w * (uint32_t)h;
-g_sgfx_stats.bytes_sent  += (uint32_t)w * (uint32_t)h * 2u;
-push_rect(pr, d, fb, x,y,w,h);
+      st->tiles_dirty  += (uint32_t)tiles;
+      st->px_overdraw  += (uint32_t)w * (uint32_t)h - box_px;
+      st->rects_pushed++;
+      st->pixels_sent  += (uint32_t)w * (uint32_t)h;
+      st->bytes_sent   += (uint32_t)w * (uint32_t)h * (pages ? 1u : 16u) / 8u;
+      if (pages){ push_pages(d, fb, x,y,w,h); continue; }
+      uint16_t c = 0;
+      int lead = ((d->drv->fill_rect && solid_ok(d, fb)) || can_repeat(d, fb)) ? solid_lead(fb, x,y,w,h, &c) : 0;
+      dither_begin(pr, d, fb, x, w);
+      if (lead == h && d->drv->fill_rect){
+        if (async) async_drain(pr, d->bus);
+        int rc = d->drv->fill_rect(d, x + fb->org_x, y + fb->org_y, w,h, rgba_of565(c));
+        if (rc) return rc;
+        st->solid_rects++;
+        st->bytes_saved += (uint32_t)w * (uint32_t)h * 2u - 2u;
+      } else if (async){
+        int rc = push_rect_async(pr, d, fb, x,y,w,h, lead, c);
+        if (rc){ async_drain(pr, d->bus); return rc; }
+      } else {
+        push_rect(pr, d, fb, x,y,w,h, lead, c);
+      }
 
-      for(int k=run_start; k<=run_end; ++k) fb->tile_dirty[ty*TX+k]=0;
     }
   }
+  if (async) async_drain(pr, d->bus);
+  sgfx_fb_clear_touched(fb);
   return SGFX_OK;
 }
@@ -37,6 +37,8 @@ struct sgfx_font {
   const sgfxf_cmap_t*  cmap;
   uint32_t cmap_count;
   const uint8_t* atlas_a8; /* pixels */
+  int native_px;  /* bitmap fonts: px drawn straight from the atlas, 0 if none */
+  void* blob;
   int owns; /* whether we malloc'd the blob */
 };
 
@@ -61,6 +63,16 @@ static sgfx_font_t* font_from_blob(void* blob, size_t len, int take_ownership){
   off += (size_t)h->cmap_count * sizeof(sgfxf_cmap_t);
   f->cmap_count = h->cmap_count;
   f->atlas_a8 = (const uint8_t*)((uint8_t*)blob + off);
+  /* a bitmap font baked at one size (same norm_scale everywhere) has a
+   * native px where every glyph is 1:1 with its atlas rect */
+  if (f->kind == SGFX_FONT_BITMAP_A8 && f->glyph_count && f->glyphs[0].norm_scale > 0.f){
+    float ns = f->glyphs[0].norm_scale;
+    f->native_px = (int)lrintf(1.0f / ns);
+    if (fabsf(f->native_px * ns - 1.0f) > 1e-4f) f->native_px = 0;
+    for (uint32_t i = 1; i < f->glyph_count && f->native_px; ++i)
+      if (f->glyphs[i].norm_scale != ns) f->native_px = 0;
+  }
+  f->blob = blob;
   f->owns = take_ownership;
   return f;
 }
@@ -70,7 +82,8 @@ sgfx_font_t* sgfx_font_open_builtin(void){
 }
 void sgfx_font_close(sgfx_font_t* f){
   if(!f) return;
-  if (f->owns){ free((void*)f->glyphs); } /* we owned whole blob */
+  sgfx_text_cache_flush(f);   /* entries are keyed by the font's address */
+  if (f->owns){ free(f->blob); } /* we owned whole blob */
   free(f);
 }
 sgfx_font_kind_t sgfx_font_kind(const sgfx_font_t* f){ return f?f->kind:0; }
@@ -117,40 +130,407 @@ static const char* next_cp(const char* p, uint32_t* out){
   *out=c; return p;
 }
 
-/* --- Glyph cache (A8 at target px) -------------------------------------- */
+/* --- Glyph cache (A8 at target px) --------------------------------------
+ * Keyed by font, codepoint, px and the style fields the raster depends on
+ * (bold_px, italic_skew, outline_px when an outline is drawn; compared bit
+ * for bit). An outlined entry carries a second plane with the outline
+ * coverage next to the fill, from the same SDF samples. Lookup is an open-addressing
+ * table with linear probing over entry indices; entries sit on an intrusive
+ * LRU list, so a hit or an eviction is O(1).
+ *
+ * Bitmaps live in one A8 atlas (static, or caller memory via
+ * sgfx_text_cache_set_atlas) packed in shelves: rows of a fixed height
+ * filled left to right. Nothing is malloc'd per glyph. When no shelf has
+ * room, the least recently used shelf is emptied and reused, or the whole
+ * atlas starts over if that shelf is too short for the glyph. */
 typedef struct {
+  const sgfx_font_t* font;
   uint32_t cp;
-  int px;               /* rounded px size */
+  int px;
+  uint32_t bold, skew;  /* float bits of bold_px / italic_skew */
+  uint32_t outline;     /* float bits of outline_px, 0 without outline */
+  uint8_t band;         /* ol holds the ring only (outline without fill) */
   int w,h, pitch;
   int bx, by;           /* bearing at target px */
   int adv;              /* advance at target px */
-  uint8_t* a8;          /* owned */
-  uint32_t lru;
+  uint8_t* a8;          /* in the atlas; NULL for empty glyphs */
+  uint8_t* ol;          /* outline coverage (a8 + w), NULL without outline */
+  int16_t prev, next;   /* LRU list, -1 ends it */
+  int16_t shelf;        /* atlas shelf, -1 if none */
 } glyph_entry_t;
 
 #ifndef SGFX_GLYPH_CACHE_N
 #define SGFX_GLYPH_CACHE_N 64
 #endif
+/* Hash slots; keep about 2x the entries so probe runs stay short */
+#ifndef SGFX_GLYPH_HASH_N
+#define SGFX_GLYPH_HASH_N (2*SGFX_GLYPH_CACHE_N)
+#endif
+#if SGFX_GLYPH_CACHE_N < 1 || SGFX_GLYPH_CACHE_N > 32767 || SGFX_GLYPH_HASH_N <= SGFX_GLYPH_CACHE_N
+# error "SGFX_GLYPH_CACHE_N must be 1..32767 and SGFX_GLYPH_HASH_N larger"
+#endif
+/* Static atlas budget in bytes (0: none until sgfx_text_cache_set_atlas) */
+#ifndef SGFX_GLYPH_ATLAS_BYTES
+#define SGFX_GLYPH_ATLAS_BYTES 16384
+#endif
+/* Atlas row length; also the widest glyph that can be cached */
+#ifndef SGFX_GLYPH_ATLAS_W
+#define SGFX_GLYPH_ATLAS_W 128
+#endif
+#ifndef SGFX_GLYPH_SHELF_N
+#define SGFX_GLYPH_SHELF_N 32
+#endif
+/* Shelf heights are rounded up to this so glyphs of near sizes share them */
+#ifndef SGFX_GLYPH_SHELF_ROUND
+#define SGFX_GLYPH_SHELF_ROUND 4
+#endif
+#if SGFX_GLYPH_ATLAS_W < 1 || SGFX_GLYPH_ATLAS_W > 65535 || SGFX_GLYPH_SHELF_N < 1 || SGFX_GLYPH_SHELF_N > 32767
+# error "SGFX_GLYPH_ATLAS_W must be 1..65535 and SGFX_GLYPH_SHELF_N 1..32767"
+#endif
+
+typedef struct {
+  int y, h;             /* rows [y, y+h) of the atlas */
+  int x;                /* next free column */
+  uint32_t tick;        /* last use, for shelf eviction */
+} glyph_shelf_t;
 
 typedef struct {
-  glyph_entry_t slot[SGFX_GLYPH_CACHE_N];
+  glyph_entry_t e[SGFX_GLYPH_CACHE_N];
+  uint16_t tab[SGFX_GLYPH_HASH_N];  /* entry index + 1, 0 = empty */
+  int16_t  mru, lru;                /* list ends */
+  int16_t  free;                    /* flushed entries, chained by next */
+  int      used;                    /* entries handed out so far */
+  sgfx_text_cache_stats_t stats;
+  /* atlas */
+  uint8_t* px;
+  int      rows;                    /* height; width is SGFX_GLYPH_ATLAS_W */
+  int      top;                     /* first row not in a shelf */
+  int      nshelf;
   uint32_t tick;
+  glyph_shelf_t shelf[SGFX_GLYPH_SHELF_N];
+  glyph_entry_t big;                /* uncacheable glyph, heap scratch */
+  size_t   big_cap;
 } glyph_cache_t;
 
 static glyph_cache_t G;
 
-static void cache_init(void){ static int inited=0; if(!inited){ memset(&G,0,sizeof G); inited=1; } }
-static glyph_entry_t* cache_find(uint32_t cp, int px){
-  cache_init(); G.tick++;
-  for (int i=0;i<SGFX_GLYPH_CACHE_N;++i){
-    if (G.slot[i].cp==cp && G.slot[i].px==px){ G.slot[i].lru=G.tick; return &G.slot[i]; }
+#if SGFX_GLYPH_ATLAS_BYTES >= SGFX_GLYPH_ATLAS_W
+static uint8_t glyph_atlas_mem[SGFX_GLYPH_ATLAS_BYTES];
+#endif
+
+/* The cache is shared by all devices; drawing text from several tasks needs
+ * a lock around it (e.g. -D'SGFX_TEXT_LOCK()=xSemaphoreTake(m,portMAX_DELAY)'). */
+#ifndef SGFX_TEXT_LOCK
+# define SGFX_TEXT_LOCK()   do{}while(0)
+#endif
+#ifndef SGFX_TEXT_UNLOCK
+# define SGFX_TEXT_UNLOCK() do{}while(0)
+#endif
+
+static void cache_init(void){
+  static int inited=0;
+  if(!inited){
+    memset(&G,0,sizeof G); G.mru = G.lru = G.free = -1;
+#if SGFX_GLYPH_ATLAS_BYTES >= SGFX_GLYPH_ATLAS_W
+    G.px = glyph_atlas_mem;
+    G.rows = SGFX_GLYPH_ATLAS_BYTES / SGFX_GLYPH_ATLAS_W;
+#endif
+    inited=1;
+  }
+}
+
+static uint32_t fbits(float v){ uint32_t u; memcpy(&u,&v,sizeof u); return u; }
+
+static uint32_t glyph_hash(const glyph_entry_t* k){
+  uint32_t h = (uint32_t)(uintptr_t)k->font * 0x9E3779B1u;
+  h = (h ^ k->cp) * 0x85EBCA77u;
+  h = (h ^ (uint32_t)k->px ^ (k->bold << 7) ^ (k->skew >> 3) ^ (k->outline << 13) ^ k->band) * 0xC2B2AE3Du;
+  return h ^ (h >> 16);
+}
+static int key_eq(const glyph_entry_t* a, const glyph_entry_t* b){
+  return a->font == b->font && a->cp == b->cp && a->px == b->px && a->bold == b->bold &&
+         a->skew == b->skew && a->outline == b->outline && a->band == b->band;
+}
+
+static void lru_unlink(int i){
+  glyph_entry_t* e = &G.e[i];
+  if (e->prev >= 0) G.e[e->prev].next = e->next; else G.mru = e->next;
+  if (e->next >= 0) G.e[e->next].prev = e->prev; else G.lru = e->prev;
+}
+static void lru_push_front(int i){
+  glyph_entry_t* e = &G.e[i];
+  e->prev = -1; e->next = G.mru;
+  if (G.mru >= 0) G.e[G.mru].prev = (int16_t)i; else G.lru = (int16_t)i;
+  G.mru = (int16_t)i;
+}
+
+static int slot_of(const glyph_entry_t* e){
+  return (int)(glyph_hash(e) % SGFX_GLYPH_HASH_N);
+}
+
+/* Remove entry i from the table; later members of its probe run move back
+ * into the hole so lookups never need tombstones. */
+static void tab_remove(int i){
+  int s = slot_of(&G.e[i]);
+  while (G.tab[s] != i + 1) s = (s + 1) % SGFX_GLYPH_HASH_N;
+  for (int j = s;;){
+    j = (j + 1) % SGFX_GLYPH_HASH_N;
+    if (!G.tab[j]) break;
+    int home = slot_of(&G.e[G.tab[j] - 1]);
+    /* move j into s unless its home lies cyclically in (s, j] */
+    if (s < j ? (home <= s || home > j) : (home <= s && home > j)){
+      G.tab[s] = G.tab[j];
+      s = j;
+    }
+  }
+  G.tab[s] = 0;
+}
+
+static void entry_drop(int i){
+  tab_remove(i);
+  lru_unlink(i);
+  G.e[i].a8 = G.e[i].ol = NULL;
+  G.e[i].font = NULL;
+}
+
+/* Drop entry i and put it on the free list. */
+static void entry_release(int i){
+  entry_drop(i);
+  G.e[i].next = G.free;
+  G.free = (int16_t)i;
+}
+
+/* Empty the whole atlas: every glyph that has pixels goes. */
+static void atlas_reset(void){
+  for (int i = G.mru; i >= 0; ){
+    int next = G.e[i].next;
+    if (G.e[i].shelf >= 0){ entry_release(i); G.stats.evictions++; }
+    i = next;
+  }
+  G.nshelf = 0;
+  G.top = 0;
+}
+
+/* Find room for a w x h bitmap; NULL if it can never fit. Best fit among
+ * open shelves, then a new shelf, then the least recently used shelf. */
+static uint8_t* atlas_alloc(int w, int h, int16_t* shelf_out){
+  if (!G.px || w > SGFX_GLYPH_ATLAS_W || h > G.rows) return NULL;
+  int sh = (h + SGFX_GLYPH_SHELF_ROUND - 1) / SGFX_GLYPH_SHELF_ROUND * SGFX_GLYPH_SHELF_ROUND;
+  if (sh > G.rows) sh = h;
+  int best = -1;
+  for (int k = 0; k < G.nshelf; ++k){
+    glyph_shelf_t* s = &G.shelf[k];
+    if (s->h >= h && s->h <= 2*sh && SGFX_GLYPH_ATLAS_W - s->x >= w && (best < 0 || s->h < G.shelf[best].h))
+      best = k;
+  }
+  if (best < 0 && G.nshelf < SGFX_GLYPH_SHELF_N && G.rows - G.top >= sh){
+    best = G.nshelf++;
+    G.shelf[best].y = G.top; G.shelf[best].h = sh; G.shelf[best].x = 0;
+    G.top += sh;
+  }
+  if (best < 0){
+    /* the least recently used shelf; if it is too short, short shelves of
+     * old sizes are pinning the space, so start the atlas over */
+    for (int k = 0; k < G.nshelf; ++k)
+      if (best < 0 || G.shelf[k].tick < G.shelf[best].tick) best = k;
+    G.stats.shelf_evictions++;
+    if (best >= 0 && G.shelf[best].h >= h){
+      for (int i = G.mru; i >= 0; ){
+        int next = G.e[i].next;
+        if (G.e[i].shelf == best){ entry_release(i); G.stats.evictions++; }
+        i = next;
+      }
+      G.shelf[best].x = 0;
+    } else {
+      atlas_reset();
+      best = G.nshelf++;
+      G.shelf[best].y = 0; G.shelf[best].h = sh; G.shelf[best].x = 0;
+      G.top = sh;
+    }
+  }
+  glyph_shelf_t* s = &G.shelf[best];
+  uint8_t* p = G.px + (size_t)s->y * SGFX_GLYPH_ATLAS_W + s->x;
+  s->x += w;
+  s->tick = G.tick;
+  *shelf_out = (int16_t)best;
+  return p;
+}
+
+static void glyph_metrics(const sgfxf_glyph_t* g, int px, int* ow, int* oh,
+                          int* obx, int* oby, int* oadv);
+static void rasterize_sdf(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
+                          float bold_px, float outline_px, int band, float skew,
+                          uint8_t* dst, uint8_t* ol, int pitch, int w, int h);
+
+/* 1: rasterize with the float reference path instead of 16.16 fixed point.
+ * Host builds (SGFX_HAL_VIRTUAL) always compile it, for sgfx_text_sdf_ref_diff. */
+#ifndef SGFX_TEXT_SDF_FLOAT
+#define SGFX_TEXT_SDF_FLOAT 0
+#endif
+#if SGFX_TEXT_SDF_FLOAT || defined(SGFX_HAL_VIRTUAL)
+#define SGFX_TEXT_SDF_REF 1
+static void rasterize_sdf_ref(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
+                              float bold_px, float outline_px, int band, float skew,
+                              uint8_t* dst, uint8_t* ol, int pitch, int w, int h);
+#endif
+static void rasterize_bitmap(const sgfx_font_t* f, const sgfxf_glyph_t* g,
+                             uint8_t* dst, int pitch, int w, int h);
+static int  bitmap_pad(float outline_px);
+static void bitmap_outline(const uint8_t* a8, uint8_t* ol, int pitch, int w, int h,
+                           float r, int band);
+
+/* Fill and outline colours of a style (alpha 0: layer not drawn) */
+static sgfx_rgba8_t fill_color(const sgfx_text_style_t* st){
+  sgfx_rgba8_t c = st->color; c.a = (uint8_t)((c.a * (int)st->fill_alpha)/255);
+  return c;
+}
+static sgfx_rgba8_t outline_color(const sgfx_text_style_t* st){
+  sgfx_rgba8_t c = st->outline_color;
+  c.a = st->outline_px > 0.f ? st->outline_alpha : 0;
+  return c;
+}
+
+/* Coverage of g at w x h into dst, and the outline plane into ol if set.
+ * Bitmap glyphs sit pad px in from each edge to leave room for it. */
+static void rasterize(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
+                      const sgfx_text_style_t* st, int band, int pad,
+                      uint8_t* dst, uint8_t* ol, int pitch, int w, int h){
+  if (f->kind != SGFX_FONT_BITMAP_A8){
+#if SGFX_TEXT_SDF_FLOAT
+    rasterize_sdf_ref(f, g, px, st->bold_px, st->outline_px, band, st->italic_skew,
+                      dst, ol, pitch, w, h);
+#else
+    rasterize_sdf(f, g, px, st->bold_px, st->outline_px, band, st->italic_skew,
+                  dst, ol, pitch, w, h);
+#endif
+    return;
+  }
+  if (pad) for (int y = 0; y < h; ++y) memset(dst + (size_t)y*pitch, 0, (size_t)w);
+  rasterize_bitmap(f, g, dst + (size_t)pad*pitch + pad, pitch, w - 2*pad, h - 2*pad);
+  if (ol) bitmap_outline(dst, ol, pitch, w, h, st->outline_px, band);
+}
+
+/* Cached raster of glyph g (codepoint cp) for style st; NULL if it could
+ * not be rasterized. A glyph too big for the atlas goes to a heap scratch
+ * that stays valid until the next call. */
+static const glyph_entry_t* cache_get(const sgfx_font_t* f, const sgfxf_glyph_t* g,
+                                      uint32_t cp, int px, const sgfx_text_style_t* st){
+  cache_init();
+  glyph_entry_t tmp = {0};
+  tmp.font = f; tmp.cp = cp; tmp.px = px;
+  if (f->kind != SGFX_FONT_BITMAP_A8){   /* bitmaps ignore bold and skew */
+    tmp.bold = fbits(st->bold_px); tmp.skew = fbits(st->italic_skew);
+  }
+  if (outline_color(st).a){
+    tmp.outline = fbits(st->outline_px);
+    tmp.band = fill_color(st).a == 0;
+  }
+  int s = (int)(glyph_hash(&tmp) % SGFX_GLYPH_HASH_N);
+  G.tick++;
+  for (; G.tab[s]; s = (s + 1) % SGFX_GLYPH_HASH_N){
+    int i = G.tab[s] - 1;
+    glyph_entry_t* e = &G.e[i];
+    if (key_eq(e, &tmp)){
+      G.stats.hits++;
+      if (G.mru != i){ lru_unlink(i); lru_push_front(i); }
+      if (e->shelf >= 0) G.shelf[e->shelf].tick = G.tick;
+      return e;
+    }
+  }
+  G.stats.misses++;
+  glyph_metrics(g, px, &tmp.w, &tmp.h, &tmp.bx, &tmp.by, &tmp.adv);
+  tmp.pitch = SGFX_GLYPH_ATLAS_W;
+  tmp.shelf = -1;
+  int pad = 0;   /* bitmap outlines grow the box; SDFs have the bake spread */
+  if (tmp.w > 0 && tmp.h > 0 && tmp.outline && f->kind == SGFX_FONT_BITMAP_A8){
+    pad = bitmap_pad(st->outline_px);
+    tmp.w += 2*pad; tmp.h += 2*pad;
+    tmp.bx -= pad; tmp.by += pad;
   }
-  int k=0; for (int i=1;i<SGFX_GLYPH_CACHE_N;++i) if (G.slot[i].lru < G.slot[k].lru) k=i;
-  if (G.slot[k].a8) { free(G.slot[k].a8); memset(&G.slot[k],0,sizeof(G.slot[k])); }
-  return &G.slot[k];
+  if (tmp.w > 0 && tmp.h > 0){
+    const int planes = tmp.outline ? 2 : 1;   /* outline plane sits right of the fill */
+    tmp.a8 = atlas_alloc(tmp.w * planes, tmp.h, &tmp.shelf);
+    if (!tmp.a8){
+      size_t need = (size_t)tmp.w * planes * tmp.h;
+      if (need > G.big_cap){
+        uint8_t* nb = (uint8_t*)realloc(G.big.a8, need);
+        if (!nb) return NULL;
+        G.big.a8 = nb; G.big_cap = need;
+      }
+      uint8_t* buf = G.big.a8;
+      G.big = tmp;
+      G.big.a8 = buf; G.big.pitch = tmp.w * planes;
+      G.big.ol = tmp.outline ? buf + tmp.w : NULL;
+      rasterize(f,g,px, st, tmp.band, pad, buf, G.big.ol, G.big.pitch, tmp.w, tmp.h);
+      return &G.big;
+    }
+    tmp.ol = tmp.outline ? tmp.a8 + tmp.w : NULL;
+    rasterize(f,g,px, st, tmp.band, pad, tmp.a8, tmp.ol, tmp.pitch, tmp.w, tmp.h);
+  }
+  int i;
+  if (G.free >= 0){ i = G.free; G.free = G.e[i].next; }
+  else if (G.used < SGFX_GLYPH_CACHE_N) i = G.used++;
+  else {
+    /* its pixels stay in the shelf until the shelf is reused */
+    i = G.lru;
+    entry_drop(i);
+    G.stats.evictions++;
+  }
+  /* drops above may have pulled later entries back into our probe run */
+  s = (int)(glyph_hash(&tmp) % SGFX_GLYPH_HASH_N);
+  while (G.tab[s]) s = (s + 1) % SGFX_GLYPH_HASH_N;
+  G.e[i] = tmp;
+  G.tab[s] = (uint16_t)(i + 1);
+  lru_push_front(i);
+  return &G.e[i];
+}
+
+/* Drop every entry of font f (all fonts if f is NULL). */
+static void cache_flush(const sgfx_font_t* f){
+  cache_init();
+  for (int i = G.mru; i >= 0; ){
+    int next = G.e[i].next;
+    if (!f || G.e[i].font == f) entry_release(i);
+    i = next;
+  }
+  if (!f){ G.nshelf = 0; G.top = 0; }
+}
+
+void sgfx_text_cache_flush(const sgfx_font_t* f){
+  SGFX_TEXT_LOCK();
+  cache_flush(f);
+  SGFX_TEXT_UNLOCK();
+}
+
+int sgfx_text_cache_set_atlas(void* mem, size_t bytes){
+  if (mem && bytes < SGFX_GLYPH_ATLAS_W) return SGFX_ERR_INVAL;
+  SGFX_TEXT_LOCK();
+  cache_flush(NULL);
+  if (mem){
+    G.px = (uint8_t*)mem;
+    G.rows = (int)(bytes / SGFX_GLYPH_ATLAS_W > 32767 ? 32767 : bytes / SGFX_GLYPH_ATLAS_W);
+  } else {
+#if SGFX_GLYPH_ATLAS_BYTES >= SGFX_GLYPH_ATLAS_W
+    G.px = glyph_atlas_mem;
+    G.rows = SGFX_GLYPH_ATLAS_BYTES / SGFX_GLYPH_ATLAS_W;
+#else
+    G.px = NULL; G.rows = 0;
+#endif
+  }
+  SGFX_TEXT_UNLOCK();
+  return SGFX_OK;
+}
+
+void sgfx_text_cache_stats(sgfx_text_cache_stats_t* out, int reset){
+  SGFX_TEXT_LOCK();
+  cache_init();
+  if (out) *out = G.stats;
+  if (reset) memset(&G.stats, 0, sizeof G.stats);
+  SGFX_TEXT_UNLOCK();
 }
 
 /* --- SDF sampling utilities -------------------------------------------- */
+
 static inline uint8_t clamp_u8(int v){ if(v<0) return 0; if(v>255) return 255; return (uint8_t)v; }
 /* SDF is stored with 0..255 where 128 ≈ distance 0; scale factor chosen during bake */
 static uint8_t sdf_sample(const uint8_t* img,int iw,int ih,int ix,int iy){
@@ -158,20 +538,26 @@ static uint8_t sdf_sample(const uint8_t* img,int iw,int ih,int ix,int iy){
   return img[iy*iw+ix];
 }
 
-/* Rasterize a glyph from SDF to A8 at integer px size with AA + transforms */
-static void rasterize_sdf(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
-                          float bold_px, float outline_px, float skew,
-                          uint8_t** out_a8, int* ow,int* oh,int* opitch,
-                          int* obx,int* oby,int* oadv)
+/* Size and placement of glyph g at integer px size. */
+static void glyph_metrics(const sgfxf_glyph_t* g, int px, int* ow, int* oh,
+                          int* obx, int* oby, int* oadv)
 {
   /* scale from font design to px: glyph metrics are at norm_scale per px */
   float S = (float)px * g->norm_scale;
-  int gw = (int)ceilf(g->gw * S);
-  int gh = (int)ceilf(g->gh * S);
-  int pitch = gw;
-  uint8_t* buf = (uint8_t*)malloc((size_t)gh*pitch); if(!buf){ *ow=*oh=*opitch=0; *out_a8=NULL; return; }
-  memset(buf,0,(size_t)gh*pitch);
+  *ow = (int)ceilf(g->gw * S);
+  *oh = (int)ceilf(g->gh * S);
+  *obx = (int)lrintf(g->bearing_x * S);
+  *oby = (int)lrintf(g->bearing_y * S);
+  *oadv= (int)lrintf(g->advance   * S);
+}
 
+#ifdef SGFX_TEXT_SDF_REF
+/* Float reference: bilinear sample + smoothstep-ish ramp per pixel. */
+static void rasterize_sdf_ref(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
+                              float bold_px, float outline_px, int band, float skew,
+                              uint8_t* dst, uint8_t* ol, int pitch, int gw, int gh)
+{
+  float S = (float)px * g->norm_scale;
   /* inverse scale for sampling atlas */
   float invS = 1.0f / S;
   const uint8_t* atlas = f->atlas_a8;
@@ -201,14 +587,247 @@ static void rasterize_sdf(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
       /* convert SDF to alpha (0..255): inside if value > 128 (+bias) */
       float dist = (a - 128.0f) - bold_bias;
       float alpha = 255.0f * fminf(fmaxf(0.5f + dist/32.0f, 0.0f), 1.0f); /* smoothstep-ish */
-      buf[y*pitch + x] = clamp_u8((int)alpha);
+      dst[y*pitch + x] = clamp_u8((int)alpha);
+      if (ol){
+        /* outline: the same ramp outline_px further out */
+        float oa = 255.0f * fminf(fmaxf(0.5f + (dist + outline_rad)/32.0f, 0.0f), 1.0f);
+        int o = (int)oa;
+        ol[y*pitch + x] = clamp_u8(band ? o - dst[y*pitch + x] : o);
+      }
     }
   }
+}
+#endif
 
-  *out_a8 = buf; *ow=gw; *oh=gh; *opitch=pitch;
-  *obx = (int)lrintf(g->bearing_x * S);
-  *oby = (int)lrintf(g->bearing_y * S);
-  *oadv= (int)lrintf(g->advance   * S);
+/* 16.16 fixed point. Rows step u by a constant; the columns whose 2x2
+ * footprint lies inside the atlas run without clamping, only the ends (and
+ * rows at the top/bottom edge) go through sdf_sample. Alpha comes from a
+ * 257-entry table over the SDF value, interpolated on its 8-bit fraction;
+ * the outline plane reads a second table from the same sample. */
+#define SDF_ONE 65536
+
+static int32_t fx_floor(int32_t v){ return v >= 0 ? v >> 16 : -(int32_t)(((uint32_t)-v + 0xFFFFu) >> 16); }
+
+/* alpha for SDF value i (0..256); same ramp as the float path:
+ * 255 * clamp(0.5 + (i - 128 - bias) / 32) with bias in 8.8 */
+static void sdf_alpha_lut(uint8_t lut[257], int32_t bias88){
+  for (int i = 0; i <= 256; ++i){
+    int32_t d = (i - 128) * 256 - bias88 + 16 * 256;
+    lut[i] = clamp_u8(d <= 0 ? 0 : (int)((255 * d) / (32 * 256)));
+  }
+}
+
+/* bilinear SDF value in 8.8 (0..255<<8) */
+static inline int sdf_texel(const uint8_t* p, int aw, int fu, int fv){
+  int p00 = p[0], p10 = p[1], p01 = p[aw], p11 = p[aw + 1];
+  int a0 = (p00 << 8) + fu * (p10 - p00);
+  int a1 = (p01 << 8) + fu * (p11 - p01);
+  return ((a0 << 8) + fv * (a1 - a0)) >> 8;
+}
+
+static int sdf_texel_edge(const sgfx_font_t* f, int32_t u, int32_t v){
+  int iu = fx_floor(u), iv = fx_floor(v);
+  int fu = ((uint32_t)u >> 8) & 255, fv = ((uint32_t)v >> 8) & 255;
+  uint8_t q[2][3];                                  /* 2x2 with stride 3 */
+  q[0][0] = sdf_sample(f->atlas_a8, f->atlas_w, f->atlas_h, iu,   iv);
+  q[0][1] = sdf_sample(f->atlas_a8, f->atlas_w, f->atlas_h, iu+1, iv);
+  q[1][0] = sdf_sample(f->atlas_a8, f->atlas_w, f->atlas_h, iu,   iv+1);
+  q[1][1] = sdf_sample(f->atlas_a8, f->atlas_w, f->atlas_h, iu+1, iv+1);
+  return sdf_texel(&q[0][0], 3, fu, fv);
+}
+
+static inline uint8_t lut_at(const uint8_t* lut, int a){
+  int i = a >> 8, t = a & 255;
+  return (uint8_t)(lut[i] + (((lut[i + 1] - lut[i]) * t) >> 8));
+}
+
+/* write fill (and outline) coverage for SDF value a at x */
+static inline void sdf_put(uint8_t* out, uint8_t* ol, int x, int a, const uint8_t (*lut)[257], int band){
+  uint8_t c = lut_at(lut[0], a);
+  out[x] = c;
+  if (ol){
+    uint8_t o = lut_at(lut[1], a);
+    ol[x] = band ? (uint8_t)(o > c ? o - c : 0) : o;
+  }
+}
+
+/* Rasterize a glyph from SDF to A8 at integer px size with AA + transforms,
+ * into the w x h box at dst (sized by glyph_metrics); ol, if set, gets the
+ * outline coverage (or just the ring with band). */
+static void rasterize_sdf(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
+                          float bold_px, float outline_px, int band, float skew,
+                          uint8_t* dst, uint8_t* ol, int pitch, int gw, int gh)
+{
+  static uint8_t lut[2][257];                              /* fill, outline */
+  static int32_t lut_bias[2] = { INT32_MIN, INT32_MIN };
+  /* per-glyph setup is the only float work */
+  float S = (float)px * g->norm_scale;
+  int32_t du = (int32_t)lrintf((float)SDF_ONE / S);        /* atlas texels per px */
+  int32_t sk = (int32_t)lrintf(skew * (float)SDF_ONE);
+  int32_t bias[2];
+  bias[0] = (int32_t)lrintf(bold_px * 32.f * 256.f);       /* tune vs your bake spread */
+  bias[1] = bias[0] - (int32_t)lrintf(outline_px * 32.f * 256.f);
+  for (int k = 0; k < (ol ? 2 : 1); ++k)
+    if (bias[k] != lut_bias[k]){ sdf_alpha_lut(lut[k], bias[k]); lut_bias[k] = bias[k]; }
+
+  const int aw = f->atlas_w, ah = f->atlas_h;
+  const int64_t umax = (int64_t)(aw - 1) * SDF_ONE;        /* iu+1 must stay < aw */
+  for(int y=0;y<gh;++y){
+    uint8_t* out = dst + (size_t)y*pitch;
+    uint8_t* oo = ol ? ol + (size_t)y*pitch : NULL;
+    int32_t v = (int32_t)(((int64_t)g->gy << 16) + (((int64_t)(2*y + 1) * du) >> 1));
+    /* italic skew shifts the row's sample start by skew*(y-gh) px */
+    int64_t u0 = ((int64_t)g->gx << 16) + (du >> 1) + (((int64_t)sk * (y - gh) * du) >> 16);
+    int x0 = 0, x1 = 0;
+    int32_t iv = fx_floor(v);
+    if (iv >= 0 && iv + 1 < ah && du > 0){
+      /* columns with 0 <= u < umax */
+      x0 = u0 >= 0 ? 0 : (int)((-u0 + du - 1) / du);
+      x1 = u0 >= umax ? 0 : (int)((umax - u0 + du - 1) / du);
+      if (x0 > gw) x0 = gw;
+      if (x1 > gw) x1 = gw;
+      if (x1 < x0) x1 = x0;
+    }
+    int x = 0;
+    for(; x < x0; ++x) sdf_put(out, oo, x, sdf_texel_edge(f, (int32_t)(u0 + (int64_t)x*du), v), lut, band);
+    if (x < x1){
+      const uint8_t* row = f->atlas_a8 + (size_t)iv*aw;
+      int fv = ((uint32_t)v >> 8) & 255;
+      int32_t u = (int32_t)(u0 + (int64_t)x*du);
+      for(; x < x1; ++x, u += du)
+        sdf_put(out, oo, x, sdf_texel(row + (u >> 16), aw, (u >> 8) & 255, fv), lut, band);
+    }
+    for(; x < gw; ++x) sdf_put(out, oo, x, sdf_texel_edge(f, (int32_t)(u0 + (int64_t)x*du), v), lut, band);
+  }
+}
+
+/* --- Bitmap (A8) glyphs ------------------------------------------------- */
+/* Bitmap atlases hold coverage, not distances. At the font's native px a
+ * glyph without outline is blitted straight from the font atlas with no
+ * cache entry; other sizes and outlined glyphs are rasterized once into the
+ * cache. The outline is the coverage dilated by outline_px; bold_px and
+ * italic_skew only apply to SDF fonts. */
+
+/* Fill e with glyph g read in place from the atlas if px is the font's
+ * native size and st draws no outline; 0 otherwise. */
+static int bitmap_native(const sgfx_font_t* f, const sgfxf_glyph_t* g, int px,
+                         const sgfx_text_style_t* st, glyph_entry_t* e){
+  if (px != f->native_px || outline_color(st).a) return 0;
+  e->w = g->gw; e->h = g->gh;
+  e->bx = g->bearing_x; e->by = g->bearing_y; e->adv = g->advance;
+  e->pitch = f->atlas_w;
+  e->a8 = e->w > 0 && e->h > 0 ? (uint8_t*)f->atlas_a8 + (size_t)g->gy*f->atlas_w + g->gx : NULL;
+  e->ol = NULL;
+  return 1;
+}
+
+/* Resample the gw x gh atlas rect to w x h. Downscales average the source
+ * box under each target pixel (an exact k x k mean for integer factors);
+ * upscales take the nearest texel. */
+#define BOX_COLS 64
+static void rasterize_bitmap(const sgfx_font_t* f, const sgfxf_glyph_t* g,
+                             uint8_t* dst, int pitch, int w, int h)
+{
+  const int sw = g->gw, sh = g->gh, aw = f->atlas_w;
+  const uint8_t* src = f->atlas_a8 + (size_t)g->gy*aw + g->gx;
+  if (w > sw || h > sh){
+    for (int y = 0; y < h; ++y){
+      const uint8_t* row = src + (size_t)(((2*y + 1) * sh) / (2*h)) * aw;
+      for (int x = 0; x < w; ++x) dst[(size_t)y*pitch + x] = row[((2*x + 1) * sw) / (2*w)];
+    }
+    return;
+  }
+  /* sum / n as a multiply; off by at most one for glyph-sized boxes */
+  uint32_t n = (uint32_t)sw * (uint32_t)sh;
+  if (sw % w == 0 && sh % h == 0 && sw / w == sh / h){
+    const int k = sw / w;
+    n = (uint32_t)(k*k);
+    const uint64_t inv = (((uint64_t)1 << 32) + n - 1) / n;
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x){
+        const uint8_t* p = src + (size_t)y*k*aw + x*k;
+        uint32_t sum = 0;
+        for (int j = 0; j < k; ++j, p += aw)
+          for (int i = 0; i < k; ++i) sum += p[i];
+        dst[(size_t)y*pitch + x] = (uint8_t)(((sum + n/2) * inv) >> 32);
+      }
+    return;
+  }
+  /* Target pixel x spans source [x*sw, (x+1)*sw) in units of 1/w and texel
+   * i spans [i*w, (i+1)*w): a partial first texel, whole ones, a partial
+   * last one, with integer weights adding up to sw (sh down a column). */
+  const uint64_t inv = (((uint64_t)1 << 32) + n - 1) / n;
+  uint16_t ci[BOX_COLS], cf[BOX_COLS];   /* first texel and its weight */
+  for (int xs = 0; xs < w; xs += BOX_COLS){
+    const int cw = w - xs < BOX_COLS ? w - xs : BOX_COLS;
+    for (int x = 0; x < cw; ++x){
+      const int x0 = (xs + x) * sw, r = w - x0 % w;
+      ci[x] = (uint16_t)(x0 / w);
+      cf[x] = (uint16_t)(r < sw ? r : sw);
+    }
+    for (int y = 0; y < h; ++y){
+      const int y0 = y*sh, r = h - y0 % h;
+      const int j0 = y0 / h, wf = r < sh ? r : sh;
+      uint8_t* out = dst + (size_t)y*pitch + xs;
+      for (int x = 0; x < cw; ++x){
+        uint32_t sum = 0;
+        int j = j0, wy = wf, ry = sh;
+        for (;;){
+          const uint8_t* p = src + (size_t)j*aw + ci[x];
+          uint32_t rs = (uint32_t)cf[x] * p[0];
+          int rx = sw - cf[x];
+          for (; rx >= w; rx -= w) rs += (uint32_t)w * *++p;
+          if (rx) rs += (uint32_t)rx * p[1];
+          sum += rs * (uint32_t)wy;
+          ry -= wy;
+          if (!ry) break;
+          ++j;
+          wy = ry < h ? ry : h;
+        }
+        out[x] = (uint8_t)(((sum + n/2) * inv) >> 32);
+      }
+    }
+  }
+}
+
+/* Widest bitmap outline, in px (the dilation disc is at most 17 x 17) */
+#define BITMAP_OUTLINE_MAX 8
+static int bitmap_pad(float outline_px){
+  int r = (int)ceilf(outline_px);
+  return r < BITMAP_OUTLINE_MAX ? r : BITMAP_OUTLINE_MAX;
+}
+
+/* Outline plane of a bitmap glyph: the fill dilated by r px, i.e. the max
+ * of the fill over a disc, texels at distance d weighted by clamp(r+1-d) so
+ * fractional radii fade in. With band, only the part outside the fill. */
+static void bitmap_outline(const uint8_t* a8, uint8_t* ol, int pitch, int w, int h,
+                           float r, int band)
+{
+  enum { N = (2*BITMAP_OUTLINE_MAX + 1) * (2*BITMAP_OUTLINE_MAX + 1) };
+  int8_t ox[N], oy[N];
+  uint16_t wt[N];   /* 8.8 */
+  int n = 0;
+  const int R = bitmap_pad(r);
+  if (r > (float)R) r = (float)R;
+  for (int dy = -R; dy <= R; ++dy)
+    for (int dx = -R; dx <= R; ++dx){
+      float t = r + 1.f - sqrtf((float)(dx*dx + dy*dy));
+      if (t <= 0.f) continue;
+      ox[n] = (int8_t)dx; oy[n] = (int8_t)dy;
+      wt[n++] = t >= 1.f ? 256 : (uint16_t)(t * 256.f);
+    }
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x){
+      int m = 0;
+      for (int k = 0; k < n && m < 255; ++k){
+        const int X = x + ox[k], Y = y + oy[k];
+        if (X < 0 || Y < 0 || X >= w || Y >= h) continue;
+        int v = (a8[(size_t)Y*pitch + X] * wt[k]) >> 8;
+        if (v > m) m = v;
+      }
+      const int c = a8[(size_t)y*pitch + x];
+      ol[(size_t)y*pitch + x] = (uint8_t)(band ? (m > c ? m - c : 0) : m);
+    }
 }
 
 /* --- Draw / Measure ------------------------------------------------------ */
@@ -218,6 +837,7 @@ void sgfx_text_measure_line(const char* s, const sgfx_font_t* f,
                             const sgfx_text_style_t* st, sgfx_text_metrics_t* out)
 {
   if(!s||!f||!st||!out) return;
+  SGFX_TEXT_LOCK();
   int px = round_px(st->px);
   int ascent  = (int)lrintf(f->ascender * st->px);
   int descent = (int)lrintf(-f->descender * st->px);
@@ -226,84 +846,88 @@ void sgfx_text_measure_line(const char* s, const sgfx_font_t* f,
   for(const char* p=s; *p; ){
     uint32_t cp; p = next_cp(p,&cp);
     const sgfxf_glyph_t* g = font_lookup(f,cp);
-    if(!g){ adv += px/2; continue; }
-    glyph_entry_t* ge = cache_find(cp, px);
-    if (!ge->a8){
-      rasterize_sdf(f,g,px, st->bold_px, st->outline_px, st->italic_skew,
-                    &ge->a8,&ge->w,&ge->h,&ge->pitch,&ge->bx,&ge->by,&ge->adv);
-      ge->cp=cp; ge->px=px;
-    }
+    glyph_entry_t nat;
+    const glyph_entry_t* ge = !g ? NULL : bitmap_native(f, g, px, st, &nat) ? &nat
+                                        : cache_get(f, g, cp, px, st);
+    if(!ge){ adv += px/2; continue; }
     adv += ge->adv + (int)lrintf(st->letter_spacing);
     if (ge->h > maxh) maxh = ge->h;
   }
   out->ascent=ascent; out->descent=descent; out->line_gap=linegap;
   out->advance=adv; out->bbox_w=adv; out->bbox_h=maxh;
+  SGFX_TEXT_UNLOCK();
 }
 
+/* One pass per glyph: shadow, outline and fill go to the fb as layers of a
+ * single blend, so each pixel under the glyph is read and written once.
+ * The run used to be walked three times (shadows, outlines, fills); to keep
+ * a glyph's fill above the next glyph's shadow and outline, the previous
+ * fill is laid back over them where they overlap (cover_only). */
 void sgfx_text_draw_line(sgfx_fb_t* fb, int x, int y,
                          const char* s, const sgfx_font_t* f,
                          const sgfx_text_style_t* st)
 {
   if(!fb||!s||!f||!st) return;
+  SGFX_TEXT_LOCK();
   int px = round_px(st->px);
   int pen_x = x, baseline = y;
-  /* optional shadow pass */
-  if (st->shadow_alpha){
-    sgfx_rgba8_t sc = st->color; sc.a = (uint8_t)((sc.a * (int)st->shadow_alpha)/255);
-    for(const char* p=s; *p; ){
-      uint32_t cp; p = next_cp(p,&cp);
-      const sgfxf_glyph_t* g = font_lookup(f,cp); if(!g){ pen_x += px/2; continue; }
-      glyph_entry_t* ge = cache_find(cp, px);
-      if (!ge->a8){
-        rasterize_sdf(f,g,px, st->bold_px, st->outline_px, st->italic_skew,
-                      &ge->a8,&ge->w,&ge->h,&ge->pitch,&ge->bx,&ge->by,&ge->adv);
-        ge->cp=cp; ge->px=px;
-      }
-      int gx = pen_x + ge->bx + st->shadow_dx;
-      int gy = baseline - ge->by + st->shadow_dy;
-      sgfx_fb_blit_a8(fb, gx, gy, ge->a8, ge->pitch, ge->w, ge->h, sc);
-      pen_x += ge->adv + (int)lrintf(st->letter_spacing);
-    }
-    pen_x = x; /* reset for fill/outline pass */
-  }
-
-  /* outline first (if requested) */
-  if (st->outline_px > 0.f && st->outline_alpha){
-    sgfx_rgba8_t oc = st->outline_color; oc.a = st->outline_alpha;
-    for(const char* p=s; *p; ){
-      uint32_t cp; p = next_cp(p,&cp);
-      const sgfxf_glyph_t* g = font_lookup(f,cp); if(!g){ pen_x += px/2; continue; }
-      glyph_entry_t* ge = cache_find(cp, px);
-      if (!ge->a8){
-        rasterize_sdf(f,g,px, st->bold_px, st->outline_px, st->italic_skew,
-                      &ge->a8,&ge->w,&ge->h,&ge->pitch,&ge->bx,&ge->by,&ge->adv);
-        ge->cp=cp; ge->px=px;
-      }
-      int gx = pen_x + ge->bx;
-      int gy = baseline - ge->by;
-      /* crude outline by drawing a thickened version: small 8-neighborhood grow */
-      for(int dy=-1; dy<=1; ++dy)
-        for(int dx=-1; dx<=1; ++dx)
-          sgfx_fb_blit_a8(fb, gx+dx, gy+dy, ge->a8, ge->pitch, ge->w, ge->h, oc);
-      pen_x += ge->adv + (int)lrintf(st->letter_spacing);
-    }
-    pen_x = x;
-  }
-
-  /* fill */
-  sgfx_rgba8_t fc = st->color; fc.a = (uint8_t)((fc.a * (int)st->fill_alpha)/255);
+  const sgfx_rgba8_t fc = fill_color(st), oc = outline_color(st);
+  sgfx_rgba8_t sc = st->color; sc.a = (uint8_t)((sc.a * (int)st->shadow_alpha)/255);
+  sgfx_a8_layer_t prev = {0};   /* last glyph's fill, a8 NULL if none */
   for(const char* p=s; *p; ){
     uint32_t cp; p = next_cp(p,&cp);
-    const sgfxf_glyph_t* g = font_lookup(f,cp); if(!g){ pen_x += px/2; continue; }
-    glyph_entry_t* ge = cache_find(cp, px);
-    if (!ge->a8){
-      rasterize_sdf(f,g,px, st->bold_px, st->outline_px, st->italic_skew,
-                    &ge->a8,&ge->w,&ge->h,&ge->pitch,&ge->bx,&ge->by,&ge->adv);
-      ge->cp=cp; ge->px=px;
-    }
+    const sgfxf_glyph_t* g = font_lookup(f,cp);
+    uint32_t shelf_ev = G.stats.shelf_evictions;
+    glyph_entry_t nat;
+    const glyph_entry_t* ge = !g ? NULL : bitmap_native(f, g, px, st, &nat) ? &nat
+                                        : cache_get(f, g, cp, px, st);
+    if(!ge){ pen_x += px/2; continue; }
+    /* its pixels may have been reused for this glyph */
+    if (G.stats.shelf_evictions != shelf_ev) prev.a8 = NULL;
     int gx = pen_x + ge->bx;
     int gy = baseline - ge->by;
-    sgfx_fb_blit_a8(fb, gx, gy, ge->a8, ge->pitch, ge->w, ge->h, fc);
     pen_x += ge->adv + (int)lrintf(st->letter_spacing);
+    if (!ge->a8) continue;
+    sgfx_a8_layer_t L[SGFX_A8_LAYERS_MAX];
+    int n = 0;
+    if (sc.a) L[n++] = (sgfx_a8_layer_t){ ge->a8, ge->pitch, gx + st->shadow_dx, gy + st->shadow_dy, ge->w, ge->h, sc, 0 };
+    if (ge->ol) L[n++] = (sgfx_a8_layer_t){ ge->ol, ge->pitch, gx, gy, ge->w, ge->h, oc, 0 };
+    if (n && prev.a8) L[n++] = prev;
+    if (fc.a) L[n++] = (sgfx_a8_layer_t){ ge->a8, ge->pitch, gx, gy, ge->w, ge->h, fc, 0 };
+    sgfx_fb_blit_a8_layers(fb, L, n);
+    if (fc.a && ge != &G.big){
+      prev = (sgfx_a8_layer_t){ ge->a8, ge->pitch, gx, gy, ge->w, ge->h, fc, 1 };
+    } else prev.a8 = NULL;
   }
-}
\ No newline at end of file
+  SGFX_TEXT_UNLOCK();
+}
+
+#ifdef SGFX_TEXT_SDF_REF
+int sgfx_text_sdf_ref_diff(const sgfx_font_t* f, uint32_t cp, const sgfx_text_style_t* st){
+  if (!f || !st || f->kind != SGFX_FONT_SDF_A8) return -1;
+  const sgfxf_glyph_t* g = font_lookup(f, cp);
+  if (!g) return -1;
+  int w, h, bx, by, adv;
+  const int px = round_px(st->px);
+  glyph_metrics(g, px, &w, &h, &bx, &by, &adv);
+  if (w <= 0 || h <= 0) return 0;
+  const int ol = outline_color(st).a != 0, band = ol && fill_color(st).a == 0;
+  const int pitch = w * (ol ? 2 : 1);   /* outline plane right of the fill, as cached */
+  uint8_t* a = (uint8_t*)malloc((size_t)pitch * h * 2);
+  if (!a) return -1;
+  uint8_t* b = a + (size_t)pitch * h;
+  SGFX_TEXT_LOCK();   /* rasterize_sdf keeps its ramp tables in statics */
+  rasterize_sdf(f, g, px, st->bold_px, st->outline_px, band, st->italic_skew,
+                a, ol ? a + w : NULL, pitch, w, h);
+  SGFX_TEXT_UNLOCK();
+  rasterize_sdf_ref(f, g, px, st->bold_px, st->outline_px, band, st->italic_skew,
+                    b, ol ? b + w : NULL, pitch, w, h);
+  int worst = 0;
+  for (size_t i = 0; i < (size_t)pitch * h; ++i){
+    int d = abs((int)a[i] - (int)b[i]);
+    if (d > worst) worst = d;
+  }
+  free(a);
+  return worst;
+}
+#endif
@@ -0,0 +1,125 @@
+/* SGFX GC9A01 driver (240x240 round RGB565 over SPI, state in d->drv_state)
+ * - Init table after Adafruit_GC9A01A / the vendor boilerplate
+ * - Rotation via MADCTL (0..3)
+ * - Optional color order (BGR/RGB); the glass needs INVON for normal colours
+ */
+#ifdef SGFX_DRV_GC9A01
+
+#include "sgfx.h"
+#include "mipi_dcs.h"
+#include "sgfx_port.h"
+#include <stdint.h>
+
+/*---------------- Tunables via build flags ----------------*/
+#ifndef SGFX_GC9A01_BGR
+#  define SGFX_GC9A01_BGR       1
+#endif
+#ifndef SGFX_GC9A01_INVERT
+#  define SGFX_GC9A01_INVERT    1
+#endif
+
+#define GC_INREGEN1  0xFE
+#define GC_INREGEN2  0xEF
+#define GC_POWER2    0xC3
+#define GC_POWER3    0xC4
+#define GC_POWER4    0xC9
+#define GC_GAMMA1    0xF0
+#define GC_GAMMA2    0xF1
+#define GC_GAMMA3    0xF2
+#define GC_GAMMA4    0xF3
+#define GC_FRAMERATE 0xE8
+
+#if SGFX_GC9A01_BGR
+#  define GC9A01_BGR MADCTL_BGR
+#else
+#  define GC9A01_BGR 0
+#endif
+
+/* Undocumented vendor registers are kept as the vendor sends them. */
+static const uint8_t gc9a01_init_seq[] = {
+  GC_INREGEN2, 0,
+  0xEB, 1, 0x14,
+  GC_INREGEN1, 0,
+  GC_INREGEN2, 0,
+  0xEB, 1, 0x14,
+  0x84, 1, 0x40,
+  0x85, 1, 0xFF,
+  0x86, 1, 0xFF,
+  0x87, 1, 0xFF,
+  0x88, 1, 0x0A,
+  0x89, 1, 0x21,
+  0x8A, 1, 0x00,
+  0x8B, 1, 0x80,
+  0x8C, 1, 0x01,
+  0x8D, 1, 0x01,
+  0x8E, 1, 0xFF,
+  0x8F, 1, 0xFF,
+  0xB6, 2, 0x00, 0x00,
+  DCS_COLMOD, 1, 0x05,                   /* RGB565 */
+  0x90, 4, 0x08, 0x08, 0x08, 0x08,
+  0xBD, 1, 0x06,
+  0xBC, 1, 0x00,
+  0xFF, 3, 0x60, 0x01, 0x04,
+  GC_POWER2, 1, 0x13,
+  GC_POWER3, 1, 0x13,
+  GC_POWER4, 1, 0x22,
+  0xBE, 1, 0x11,
+  0xE1, 2, 0x10, 0x0E,
+  0xDF, 3, 0x21, 0x0C, 0x02,
+  GC_GAMMA1, 6, 0x45, 0x09, 0x08, 0x08, 0x26, 0x2A,
+  GC_GAMMA2, 6, 0x43, 0x70, 0x72, 0x36, 0x37, 0x6F,
+  GC_GAMMA3, 6, 0x45, 0x09, 0x08, 0x08, 0x26, 0x2A,
+  GC_GAMMA4, 6, 0x43, 0x70, 0x72, 0x36, 0x37, 0x6F,
+  0xED, 2, 0x1B, 0x0B,
+  0xAE, 1, 0x77,
+  0xCD, 1, 0x63,
+  GC_FRAMERATE, 1, 0x34,
+  0x62, 12, 0x18, 0x0D, 0x71, 0xED, 0x70, 0x70, 0x18, 0x0F, 0x71, 0xEF, 0x70, 0x70,
+  0x63, 12, 0x18, 0x11, 0x71, 0xF1, 0x70, 0x70, 0x18, 0x13, 0x71, 0xF3, 0x70, 0x70,
+  0x64, 7, 0x28, 0x29, 0xF1, 0x01, 0xF1, 0x00, 0x07,
+  0x66, 10, 0x3C, 0x00, 0xCD, 0x67, 0x45, 0x45, 0x10, 0x00, 0x00, 0x00,
+  0x67, 10, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x01, 0x54, 0x10, 0x32, 0x98,
+  0x74, 7, 0x10, 0x85, 0x80, 0x00, 0x00, 0x4E, 0x00,
+  0x98, 2, 0x3E, 0x07,
+  DCS_TEON, 0,
+  SGFX_GC9A01_INVERT ? DCS_INVON : DCS_INVOFF, 0,
+  DCS_SLPOUT, 0,       DCS_WAIT(120),
+  DCS_DISPON, 0,
+};
+
+static const sgfx_dcs_panel_t gc9a01_panel = {
+  .init = gc9a01_init_seq, .init_len = sizeof gc9a01_init_seq,
+  .madctl = { GC9A01_BGR | MADCTL_MX,
+              GC9A01_BGR | MADCTL_MV,
+              GC9A01_BGR | MADCTL_MY,
+              GC9A01_BGR | MADCTL_MX | MADCTL_MY | MADCTL_MV },
+  .ram_rows = 240,
+  .ramwrc = DCS_RAMWRC,
+  .reset_ms = 120,
+  .backlight = 1,
+};
+
+static int gc9a01_init(sgfx_device_t* d){ return sgfx_dcs_init(d, &gc9a01_panel); }
+
+/*---------------- Public symbols ----------------*/
+
+const sgfx_caps_t sgfx_gc9a01_caps = {
+  .width  = SGFX_W,
+  .height = SGFX_H,
+  .native_fmt = SGFX_FMT_RGB565, .bpp = 16,
+  .caps   = SGFX_CAP_PARTIAL | SGFX_CAP_HW_FILL | SGFX_CAP_RAW_STREAM | SGFX_CAP_SCROLL |
+            SGFX_CAP_INVERT | SGFX_CAP_ROUND,
+};
+
+const sgfx_driver_ops_t sgfx_gc9a01_ops = {
+  .init         = gc9a01_init,
+  .set_window   = sgfx_dcs_set_window,
+  .write_pixels = sgfx_dcs_write_pixels,
+  .fill_rect    = sgfx_dcs_fill_rect,
+  .set_rotation = sgfx_dcs_set_rotation,
+  .invert       = sgfx_dcs_invert,
+  .deinit       = sgfx_dcs_deinit,
+  .scroll       = sgfx_dcs_scroll,
+};
+
+#endif /* SGFX_DRV_GC9A01 */
@@ -0,0 +1,109 @@
+/* SGFX ILI9341 driver (240x320 RGB565 over SPI, state in d->drv_state)
+ * - Init table after Adafruit_ILI9341, delays cut to the datasheet minimum
+ * - Rotation via MADCTL (0..3); offsets swap on MV rotations
+ * - Optional color order (BGR/RGB) and inversion
+ */
+#ifdef SGFX_DRV_ILI9341
+
+#include "sgfx.h"
+#include "mipi_dcs.h"
+#include "sgfx_port.h"
+#include <stdint.h>
+
+/*---------------- Tunables via build flags ----------------*/
+#ifndef SGFX_ILI9341_COLSTART
+#  define SGFX_ILI9341_COLSTART 0
+#endif
+#ifndef SGFX_ILI9341_ROWSTART
+#  define SGFX_ILI9341_ROWSTART 0
+#endif
+#ifndef SGFX_ILI9341_BGR
+#  define SGFX_ILI9341_BGR      1    /* almost every ILI9341 module is BGR */
+#endif
+#ifndef SGFX_ILI9341_INVERT
+#  define SGFX_ILI9341_INVERT   0
+#endif
+/* Controller RAM rows (VSCRDEF areas must add up to this) */
+#ifndef SGFX_ILI9341_RAM_ROWS
+#  define SGFX_ILI9341_RAM_ROWS 320
+#endif
+
+/*---------------- ILI9341 panel setup commands ----------------*/
+#define ILI_FRMCTR1  0xB1
+#define ILI_DFUNCTR  0xB6
+#define ILI_PWCTR1   0xC0
+#define ILI_PWCTR2   0xC1
+#define ILI_VMCTR1   0xC5
+#define ILI_VMCTR2   0xC7
+#define ILI_GAMMASET 0x26
+#define ILI_GMCTRP1  0xE0
+#define ILI_GMCTRN1  0xE1
+
+#if SGFX_ILI9341_BGR
+#  define ILI9341_BGR MADCTL_BGR
+#else
+#  define ILI9341_BGR 0
+#endif
+
+static const uint8_t ili9341_init_seq[] = {
+  0xEF, 3, 0x03, 0x80, 0x02,
+  0xCF, 3, 0x00, 0xC1, 0x30,             /* power control B */
+  0xED, 4, 0x64, 0x03, 0x12, 0x81,       /* power on sequence */
+  0xE8, 3, 0x85, 0x00, 0x78,             /* driver timing A */
+  0xCB, 5, 0x39, 0x2C, 0x00, 0x34, 0x02, /* power control A */
+  0xF7, 1, 0x20,                         /* pump ratio */
+  0xEA, 2, 0x00, 0x00,                   /* driver timing B */
+  ILI_PWCTR1,  1, 0x23,
+  ILI_PWCTR2,  1, 0x10,
+  ILI_VMCTR1,  2, 0x3E, 0x28,
+  ILI_VMCTR2,  1, 0x86,
+  DCS_COLMOD,  1, 0x55,                  /* RGB565 */
+  ILI_FRMCTR1, 2, 0x00, 0x18,            /* 79 Hz */
+  ILI_DFUNCTR, 3, 0x08, 0x82, 0x27,
+  0xF2, 1, 0x00,                         /* 3-gamma off */
+  ILI_GAMMASET, 1, 0x01,
+  ILI_GMCTRP1, 15, 0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1,
+                   0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00,
+  ILI_GMCTRN1, 15, 0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
+                   0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F,
+  SGFX_ILI9341_INVERT ? DCS_INVON : DCS_INVOFF, 0,
+  DCS_SLPOUT, 0,       DCS_WAIT(120),
+  DCS_DISPON, 0,
+};
+
+static const sgfx_dcs_panel_t ili9341_panel = {
+  .init = ili9341_init_seq, .init_len = sizeof ili9341_init_seq,
+  .madctl = { ILI9341_BGR | MADCTL_MX,                          /* portrait      */
+              ILI9341_BGR | MADCTL_MV,                          /* landscape     */
+              ILI9341_BGR | MADCTL_MY,                          /* portrait 180  */
+              ILI9341_BGR | MADCTL_MX | MADCTL_MY | MADCTL_MV },/* landscape 180 */
+  .colstart = SGFX_ILI9341_COLSTART, .rowstart = SGFX_ILI9341_ROWSTART,
+  .ram_rows = SGFX_ILI9341_RAM_ROWS,
+  .ramwrc = DCS_RAMWRC,
+  .reset_ms = 120,
+  .backlight = 1,
+};
+
+static int ili9341_init(sgfx_device_t* d){ return sgfx_dcs_init(d, &ili9341_panel); }
+
+/*---------------- Public symbols ----------------*/
+
+const sgfx_caps_t sgfx_ili9341_caps = {
+  .width  = SGFX_W,
+  .height = SGFX_H,
+  .native_fmt = SGFX_FMT_RGB565, .bpp = 16,
+  .caps   = SGFX_CAP_PARTIAL | SGFX_CAP_HW_FILL | SGFX_CAP_RAW_STREAM | SGFX_CAP_SCROLL | SGFX_CAP_INVERT,
+};
+
+const sgfx_driver_ops_t sgfx_ili9341_ops = {
+  .init         = ili9341_init,
+  .set_window   = sgfx_dcs_set_window,
+  .write_pixels = sgfx_dcs_write_pixels,
+  .fill_rect    = sgfx_dcs_fill_rect,
+  .set_rotation = sgfx_dcs_set_rotation,
+  .invert       = sgfx_dcs_invert,
+  .deinit       = sgfx_dcs_deinit,
+  .scroll       = sgfx_dcs_scroll,
+};
+
+#endif /* SGFX_DRV_ILI9341 */
@@ -0,0 +1,267 @@
+#if defined(SGFX_DRV_ST7735) || defined(SGFX_DRV_ST7789) || defined(SGFX_DRV_ST7796) || \
+    defined(SGFX_DRV_ILI9341) || defined(SGFX_DRV_GC9A01)
+
+#include "sgfx.h"
+#include "mipi_dcs.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef SGFX_SPI_SWAP_BUF_BYTES
+# ifdef SGFX_ST7735_SWAP_BUF_BYTES
+#  define SGFX_SPI_SWAP_BUF_BYTES SGFX_ST7735_SWAP_BUF_BYTES
+# else
+#  define SGFX_SPI_SWAP_BUF_BYTES 4096
+# endif
+#endif
+
+/* HAL pin-id convention: DC=0, BL=1, RST=2 (see the HALs in src/hal) */
+
+/* ---- Address window cache ----
+ * CASET / RASET are only sent when their range changes. RASET always runs to
+ * the last panel row (ymax), so after a window's w*h pixels the write pointer
+ * sits at the start of the row below it; a window with the same columns that
+ * starts there continues with RAMWRC (one byte) instead of being reopened.
+ * Relies on callers streaming exactly w*h pixels after each set_window; a
+ * write that fails partway drops the cache (dcs_fail). */
+typedef struct {
+  uint16_t x0, x1, y0, y1;   /* CASET / RASET as programmed */
+  uint16_t next_y;           /* row the write pointer stopped at */
+  uint8_t  valid;            /* x0..y1 match the controller */
+} dcs_win_t;
+
+/* last VSCRDEF */
+typedef struct { uint16_t tfa, vsa; uint8_t valid; } dcs_vscroll_t;
+
+typedef struct {
+  const sgfx_dcs_panel_t* panel;
+  uint8_t   madctl;          /* as last sent */
+  dcs_win_t win;
+  dcs_vscroll_t vs;
+  uint8_t*  swap_buf;        /* SGFX_RGB565_BYTESWAP: heap, allocated on first use */
+} dcs_state_t;
+
+static inline dcs_state_t* dcs_of(sgfx_device_t* d){ return (dcs_state_t*)d->drv_state; }
+
+/* Pixel stream cut short: the write pointer is no longer where next_y says. */
+static inline int dcs_fail(sgfx_device_t* d, int rc){
+  if (rc) dcs_of(d)->win.valid = 0;
+  return rc;
+}
+
+static inline uint16_t pack565(sgfx_rgba8_t c){
+  return (uint16_t)(((c.r & 0xF8) << 8) | ((c.g & 0xFC) << 3) | (c.b >> 3));
+}
+
+static void dcs_delay(sgfx_bus_t* b, uint32_t ms){
+  if (ms && b->ops->delay_ms) b->ops->delay_ms(b, ms);
+}
+
+static int dcs_send(sgfx_bus_t* b, uint8_t cmd, const void* data, size_t n){
+  if (b->ops->write_cmd(b, cmd)) return SGFX_ERR_EIO;
+  if (n && data && b->ops->write_data(b, data, n)) return SGFX_ERR_EIO;
+  return SGFX_OK;
+}
+
+/* One run of  cmd, n, args[n]  entries; a single transaction if the bus can. */
+static int dcs_send_run(sgfx_bus_t* b, const uint8_t* p, size_t len){
+  if (b->ops->write_cmds) return b->ops->write_cmds(b, p, len) ? SGFX_ERR_EIO : SGFX_OK;
+  for (size_t i = 0; i + 1 < len; i += 2u + p[i+1])
+    if (dcs_send(b, p[i], p + i + 2, p[i+1])) return SGFX_ERR_EIO;
+  return SGFX_OK;
+}
+
+/* Run init bytecode; wait is still owed by whatever was sent before it. */
+static int dcs_run(sgfx_bus_t* b, const uint8_t* p, size_t len, uint32_t wait){
+  size_t i = 0;
+  while (i + 1 < len){
+    if (p[i] == 0x00){                 /* DCS_WAIT */
+      if (p[i+1] > wait) wait = p[i+1];
+      i += 2;
+      continue;
+    }
+    size_t j = i;
+    while (j + 1 < len && p[j] != 0x00) j += 2u + p[j+1];
+    if (j > len) return SGFX_ERR_INVAL;
+    dcs_delay(b, wait);
+    wait = 0;
+    int rc = dcs_send_run(b, p + i, j - i);
+    if (rc) return rc;
+    i = j;
+  }
+  dcs_delay(b, wait);
+  return SGFX_OK;
+}
+
+static void dcs_offsets(const sgfx_dcs_panel_t* pn, uint8_t madctl, uint16_t* xo, uint16_t* yo){
+  if (madctl & MADCTL_MV){ *xo = pn->rowstart; *yo = pn->colstart; }
+  else                   { *xo = pn->colstart; *yo = pn->rowstart; }
+}
+
+static int dcs_addr(sgfx_bus_t* b, uint8_t cmd, uint16_t a, uint16_t e){
+  uint8_t buf[4] = { (uint8_t)(a >> 8), (uint8_t)a, (uint8_t)(e >> 8), (uint8_t)e };
+  return dcs_send(b, cmd, buf, 4);
+}
+
+/* Controller coordinates, inclusive. */
+static int dcs_window(sgfx_bus_t* b, dcs_win_t* c, uint8_t ramwrc,
+                      uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t ymax){
+  if (ymax < y1) ymax = y1;
+  const int same_x = c->valid && c->x0 == x0 && c->x1 == x1;
+  if (ramwrc && same_x && c->next_y == y0 && y1 <= c->y1){
+    c->next_y = (uint16_t)(y1 + 1);
+    return b->ops->write_cmd(b, ramwrc);
+  }
+  const int same_y = c->valid && c->y0 == y0 && c->y1 == ymax;
+  c->valid = 0;
+  if (!same_x && dcs_addr(b, DCS_CASET, x0, x1)) return SGFX_ERR_EIO;
+  if (!same_y && dcs_addr(b, DCS_RASET, y0, ymax)) return SGFX_ERR_EIO;
+  if (b->ops->write_cmd(b, DCS_RAMWR)) return SGFX_ERR_EIO;
+  c->x0 = x0; c->x1 = x1; c->y0 = y0; c->y1 = ymax;
+  c->next_y = (uint16_t)(y1 + 1);
+  c->valid = 1;
+  return SGFX_OK;
+}
+
+/* ---- Driver ops ---- */
+
+int sgfx_dcs_init(sgfx_device_t* d, const sgfx_dcs_panel_t* pn){
+  dcs_state_t* s = dcs_of(d);
+  if (!s && !(s = (dcs_state_t*)calloc(1, sizeof(*s)))) return SGFX_ERR_NOMEM;
+  d->drv_state = s;
+  s->panel = pn;
+  s->win.valid = 0;
+  s->vs.valid = 0;
+
+  /* One reset: pulse RST when the HAL has it wired, else SWRESET. */
+  sgfx_bus_t* b = d->bus;
+  if ((b->features & SGFX_BUS_HW_RESET) && b->ops->gpio_set){
+    b->ops->gpio_set(b, 2 /*RST*/, 0);
+    dcs_delay(b, 10);
+    b->ops->gpio_set(b, 2 /*RST*/, 1);
+  } else if (b->ops->write_cmd(b, DCS_SWRESET)) return SGFX_ERR_EIO;
+
+  int rc = dcs_run(b, pn->init, pn->init_len, pn->reset_ms);
+  if (rc) return rc;
+  rc = sgfx_dcs_set_rotation(d, d->rotation);
+  if (rc) return rc;
+  if (pn->backlight && b->ops->gpio_set) b->ops->gpio_set(b, 1 /*BL*/, 1);
+  return SGFX_OK;
+}
+
+int sgfx_dcs_set_rotation(sgfx_device_t* d, uint8_t rot){
+  dcs_state_t* s = dcs_of(d);
+  s->win.valid = 0;
+  s->madctl = s->panel->madctl[rot & 3];
+  return dcs_send(d->bus, DCS_MADCTL, &s->madctl, 1);
+}
+
+int sgfx_dcs_set_window(sgfx_device_t* d, int x, int y, int w, int h){
+  dcs_state_t* s = dcs_of(d);
+  uint16_t xo, yo; dcs_offsets(s->panel, s->madctl, &xo, &yo);
+  uint16_t x0 = (uint16_t)(x + xo);
+  uint16_t y0 = (uint16_t)(y + yo);
+  uint16_t x1 = (uint16_t)(x + w - 1 + xo);
+  uint16_t y1 = (uint16_t)(y + h - 1 + yo);
+  uint16_t ymax = d->caps.height ? (uint16_t)(d->caps.height - 1 + yo) : y1;
+  return dcs_window(d->bus, &s->win, s->panel->ramwrc, x0, y0, x1, y1, ymax);
+}
+
+int sgfx_dcs_write_pixels(sgfx_device_t* d, const void* px, size_t count, sgfx_pixfmt_t src_fmt){
+  sgfx_bus_t* b = d->bus;
+  if (src_fmt != SGFX_FMT_RGB565)           /* count is bytes */
+    return dcs_fail(d, b->ops->write_data(b, px, count));
+#ifdef SGFX_RGB565_BYTESWAP
+  /* Panel expects big-endian RGB565; little-endian MCUs store it swapped. */
+  dcs_state_t* s = dcs_of(d);
+  if (!s->swap_buf && !(s->swap_buf = (uint8_t*)malloc(SGFX_SPI_SWAP_BUF_BYTES)))
+    return dcs_fail(d, SGFX_ERR_NOMEM);
+  const uint8_t* p = (const uint8_t*)px;
+  while (count){
+    size_t n = count > SGFX_SPI_SWAP_BUF_BYTES / 2 ? SGFX_SPI_SWAP_BUF_BYTES / 2 : count;
+    for (size_t i = 0; i < n; ++i){
+      s->swap_buf[2*i]   = p[2*i+1];
+      s->swap_buf[2*i+1] = p[2*i];
+    }
+    int rc = b->ops->write_data(b, s->swap_buf, n * 2);
+    if (rc) return dcs_fail(d, rc);
+    p += n * 2;
+    count -= n;
+  }
+  return SGFX_OK;
+#else
+  if (b->ops->write_pixels) return dcs_fail(d, b->ops->write_pixels(b, px, count, src_fmt));
+  return dcs_fail(d, b->ops->write_data(b, px, count * 2));
+#endif
+}
+
+int sgfx_dcs_fill_rect(sgfx_device_t* d, int x, int y, int w, int h, sgfx_rgba8_t c){
+  if (w <= 0 || h <= 0) return SGFX_OK;
+  int rc = sgfx_dcs_set_window(d, x, y, w, h);
+  if (rc) return dcs_fail(d, rc);
+
+  uint16_t p = pack565(c);
+#ifdef SGFX_RGB565_BYTESWAP
+  p = (uint16_t)((p >> 8) | (p << 8));
+#endif
+  sgfx_bus_t* b = d->bus;
+  size_t total = (size_t)w * (size_t)h;
+  if (b->ops->write_repeat) return dcs_fail(d, b->ops->write_repeat(b, &p, sizeof(p), total));
+
+  enum { CHUNK = 128 };
+  uint16_t tmp[CHUNK];
+  for (int i = 0; i < CHUNK; ++i) tmp[i] = p;
+  while (total){
+    size_t n = total > CHUNK ? CHUNK : total;
+    rc = b->ops->write_data(b, tmp, n * 2);
+    if (rc) return dcs_fail(d, rc);
+    total -= n;
+  }
+  return SGFX_OK;
+}
+
+int sgfx_dcs_invert(sgfx_device_t* d, bool on){
+  return dcs_send(d->bus, on ? DCS_INVON : DCS_INVOFF, NULL, 0);
+}
+
+/* ---- Vertical scrolling (VSCRDEF / VSCSAD) ----
+ * Works on controller RAM rows, i.e. only when MADCTL.MV is clear. With MY
+ * set the scan runs against the row address, so the area and the start line
+ * are mirrored. h = 0 restores the plain mapping. */
+int sgfx_dcs_scroll(sgfx_device_t* d, int top, int h, int line){
+  dcs_state_t* s = dcs_of(d);
+  const uint16_t rows = s->panel->ram_rows;
+  if (!rows || (s->madctl & MADCTL_MV)) return SGFX_ERR_NOSUP;
+  uint16_t xo, yo; dcs_offsets(s->panel, s->madctl, &xo, &yo);
+  top += yo;
+  if (h <= 0){ top = 0; h = rows; line = 0; }
+  if (top < 0 || top + h > rows) return SGFX_ERR_INVAL;
+  line %= h; if (line < 0) line += h;
+  uint16_t tfa = (uint16_t)top, ssa;
+  if (s->madctl & MADCTL_MY){
+    tfa = (uint16_t)(rows - top - h);
+    ssa = (uint16_t)(tfa + (h - line) % h);
+  } else {
+    ssa = (uint16_t)(tfa + line);
+  }
+  sgfx_bus_t* b = d->bus;
+  dcs_vscroll_t* c = &s->vs;
+  if (!c->valid || c->tfa != tfa || c->vsa != h){
+    uint16_t bfa = (uint16_t)(rows - tfa - h);
+    uint8_t def[6] = { (uint8_t)(tfa >> 8), (uint8_t)tfa, (uint8_t)(h >> 8), (uint8_t)h,
+                       (uint8_t)(bfa >> 8), (uint8_t)bfa };
+    c->valid = 0;
+    if (dcs_send(b, DCS_VSCRDEF, def, 6)) return SGFX_ERR_EIO;
+    c->tfa = tfa; c->vsa = (uint16_t)h; c->valid = 1;
+  }
+  uint8_t sa[2] = { (uint8_t)(ssa >> 8), (uint8_t)ssa };
+  return dcs_send(b, DCS_VSCSAD, sa, 2);
+}
+
+void sgfx_dcs_deinit(sgfx_device_t* d){
+  dcs_state_t* s = dcs_of(d);
+  if (s) free(s->swap_buf);
+  free(s);
+  d->drv_state = NULL;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+/* mipi_dcs.h — shared core of the MIPI-DCS SPI drivers
+ * (ST7735, ST7789, ST7796, ILI9341, GC9A01).
+ *
+ * A panel file describes its controller with a sgfx_dcs_panel_t (init
+ * bytecode, MADCTL per rotation, offsets, RAM rows) and fills its ops table
+ * with the sgfx_dcs_* functions; its init op calls sgfx_dcs_init(d, &panel).
+ * Per-device state lives in d->drv_state.
+ */
+#include "sgfx.h"
+#include <stdbool.h>
+
+/* MADCTL bits */
+#define MADCTL_MY  0x80
+#define MADCTL_MX  0x40
+#define MADCTL_MV  0x20
+#define MADCTL_ML  0x10
+#define MADCTL_RGB 0x00
+#define MADCTL_BGR 0x08
+#define MADCTL_MH  0x04
+
+/* DCS commands shared by all of them */
+#define DCS_SWRESET 0x01
+#define DCS_SLPOUT  0x11
+#define DCS_NORON   0x13
+#define DCS_INVOFF  0x20
+#define DCS_INVON   0x21
+#define DCS_DISPON  0x29
+#define DCS_CASET   0x2A
+#define DCS_RASET   0x2B
+#define DCS_RAMWR   0x2C
+#define DCS_VSCRDEF 0x33
+#define DCS_TEON    0x35
+#define DCS_MADCTL  0x36
+#define DCS_VSCSAD  0x37
+#define DCS_COLMOD  0x3A
+#define DCS_RAMWRC  0x3C
+
+/* Init bytecode: entries of  cmd, n, args[n]. cmd 0x00 (NOP) is never sent:
+ * DCS_WAIT(ms) keeps the bus idle for ms after the preceding command. The
+ * commands between two waits go out as one bus transaction (write_cmds), and
+ * back-to-back waits, including the one after reset, collapse into the
+ * longest of them. */
+#define DCS_WAIT(ms) 0x00, (ms)
+
+typedef struct {
+  const uint8_t* init;      /* bytecode run after the reset */
+  uint16_t init_len;
+  uint8_t  madctl[4];       /* per rotation, colour order and mirroring included */
+  uint16_t colstart, rowstart;   /* portrait offsets; swapped when MV is set */
+  uint16_t ram_rows;        /* controller RAM rows for VSCRDEF; 0: no scroll */
+  uint8_t  ramwrc;          /* RAMWRC opcode, 0: always reopen with RAMWR */
+  uint8_t  reset_ms;        /* wait after the hardware or software reset */
+  uint8_t  backlight;       /* switch BL on once the panel is up */
+} sgfx_dcs_panel_t;
+
+int  sgfx_dcs_init(sgfx_device_t* d, const sgfx_dcs_panel_t* panel);
+int  sgfx_dcs_set_rotation(sgfx_device_t* d, uint8_t rot);
+int  sgfx_dcs_set_window(sgfx_device_t* d, int x, int y, int w, int h);
+int  sgfx_dcs_write_pixels(sgfx_device_t* d, const void* px, size_t count, sgfx_pixfmt_t src_fmt);
+int  sgfx_dcs_fill_rect(sgfx_device_t* d, int x, int y, int w, int h, sgfx_rgba8_t c);
+int  sgfx_dcs_invert(sgfx_device_t* d, bool on);
+int  sgfx_dcs_scroll(sgfx_device_t* d, int top, int h, int line);
+void sgfx_dcs_deinit(sgfx_device_t* d);
@@ -1,6 +1,7 @@
 #ifdef SGFX_DRV_SSD1306
 
 #include "sgfx.h"
+#include "sgfx_dither.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -30,40 +31,71 @@
 #define SGFX_SH110X_COL_OFFSET 0
 #endif
 
+/* Deferred mode: fill_rect only edits s->fb; sgfx_present() diffs it against a
+ * copy of what the panel holds and sends the changed spans of each page. */
+#ifndef SGFX_SSD1306_DEFERRED
+#define SGFX_SSD1306_DEFERRED 0
+#endif
+/* Unchanged bytes between two spans that are cheaper to resend than a new
+ * COLUMNADDR/PAGEADDR window (6 command bytes, each its own I2C write). */
+#ifndef SGFX_SSD1306_SPAN_GAP
+#define SGFX_SSD1306_SPAN_GAP 16
+#endif
+
 /* ---- bus helpers ---- */
 static inline int ssd_cmd(sgfx_device_t* d, uint8_t c){ return d->bus->ops->write_cmd(d->bus, c); }
 static inline int ssd_data(sgfx_device_t* d, const void* p, size_t n){ return d->bus->ops->write_data(d->bus, p, n); }
 
-/* ---- driver state (single device) ---- */
-static struct {
+/* ---- driver state (per device, in d->drv_state) ---- */
+typedef struct {
   uint8_t* fb;              /* 1bpp, pages stacked: width*(height/8) */
+  uint8_t* sent;            /* deferred mode: panel RAM as last sent, else NULL */
   int fb_bytes;
   int w, h, pages;
   /* buffered window state for compat write_pixels path */
   int win_x, win_y, win_w, win_h;
   int cur_col, cur_row;
-} s;
+  int win_sent;             /* MONO1 path: panel window already programmed */
+  sgfx_dither_t dt;         /* FS error row for write_pixels (dev->dither) */
+  uint8_t owns_fb, owns_sent;
+} ssd_state_t;
+
+static inline ssd_state_t* ssd_of(sgfx_device_t* d){ return (ssd_state_t*)d->drv_state; }
 
 /* ---- init ---- */
+static void ssd_deinit(sgfx_device_t* d);
+
 static int ssd_init(sgfx_device_t* d){
-  s.w = d->caps.width;
-  s.h = d->caps.height;
-  s.pages = s.h / 8;
-  s.fb_bytes = s.w * s.pages;
+  ssd_deinit(d);                               /* re-init: drop the old state */
+  ssd_state_t* s = (ssd_state_t*)calloc(1, sizeof(*s));
+  if (!s) return SGFX_ERR_NOMEM;
+  d->drv_state = s;
+  s->w = d->caps.width;
+  s->h = d->caps.height;
+  s->pages = s->h / 8;
+  s->fb_bytes = s->w * s->pages;
 
   /* allocate framebuffer (use scratch if big enough, else malloc) */
-  if ((int)d->scratch_bytes >= s.fb_bytes) {
-    s.fb = (uint8_t*)d->scratch;
+  if ((int)d->scratch_bytes >= s->fb_bytes) {
+    s->fb = (uint8_t*)d->scratch;
   } else {
-    s.fb = (uint8_t*)malloc((size_t)s.fb_bytes);
-    if (!s.fb) return SGFX_ERR_NOMEM;
+    s->fb = (uint8_t*)malloc((size_t)s->fb_bytes);
+    if (!s->fb) return SGFX_ERR_NOMEM;
+    s->owns_fb = 1;
+  }
+  memset(s->fb, 0x00, (size_t)s->fb_bytes);
+
+  if (SGFX_SSD1306_DEFERRED){
+    if ((int)d->scratch_bytes >= 2*s->fb_bytes) s->sent = (uint8_t*)d->scratch + s->fb_bytes;
+    else if (!(s->sent = (uint8_t*)malloc((size_t)s->fb_bytes))) return SGFX_ERR_NOMEM;
+    else s->owns_sent = 1;
+    memset(s->sent, 0x00, (size_t)s->fb_bytes);   /* matches the clear below */
   }
-  memset(s.fb, 0x00, (size_t)s.fb_bytes);
 
   /* clean, deterministic init */
   ssd_cmd(d, SSD1306_DISPLAYOFF);
   ssd_cmd(d, SSD1306_SETDISPLAYCLOCKDIV); ssd_cmd(d, 0x80);
-  ssd_cmd(d, SSD1306_MULTIPLEX);           ssd_cmd(d, (uint8_t)(s.h-1));
+  ssd_cmd(d, SSD1306_MULTIPLEX);           ssd_cmd(d, (uint8_t)(s->h-1));
   ssd_cmd(d, SSD1306_SETDISPLAYOFFSET);    ssd_cmd(d, 0x00);
   ssd_cmd(d, SSD1306_SETSTARTLINE | 0x00);
 
@@ -73,15 +105,16 @@ static int ssd_init(sgfx_device_t* d){
   ssd_cmd(d, SSD1306_CHARGEPUMP); ssd_cmd(d, 0x14);
 #endif
 
-  /* PAGE addressing */
-  ssd_cmd(d, SSD1306_MEMORYMODE);          ssd_cmd(d, 0x02);
+  /* HORIZONTAL addressing: COLUMNADDR/PAGEADDR windows, data wraps to the
+   * next page at the right edge, so a multi-page rect is one window */
+  ssd_cmd(d, SSD1306_MEMORYMODE);          ssd_cmd(d, 0x00);
 
   /* Default orientation; rotation will change this */
   ssd_cmd(d, (uint8_t)(SSD1306_SEGREMAP | 0x01));
   ssd_cmd(d, SSD1306_COMSCANDEC);
 
-  ssd_cmd(d, SSD1306_SETCOMPINS);         ssd_cmd(d, (s.h==32) ? 0x02 : 0x12);
-  ssd_cmd(d, SSD1306_SETCONTRAST);        ssd_cmd(d, (s.h==32) ? 0x8F : 0xCF);
+  ssd_cmd(d, SSD1306_SETCOMPINS);         ssd_cmd(d, (s->h==32) ? 0x02 : 0x12);
+  ssd_cmd(d, SSD1306_SETCONTRAST);        ssd_cmd(d, (s->h==32) ? 0x8F : 0xCF);
   ssd_cmd(d, SSD1306_SETPRECHARGE);       ssd_cmd(d, 0xF1);
   ssd_cmd(d, SSD1306_SETVCOMDETECT);      ssd_cmd(d, 0x40);
   ssd_cmd(d, SSD1306_DISPLAYALLON_RESUME);
@@ -95,15 +128,15 @@ static int ssd_init(sgfx_device_t* d){
   /* full window and stream fb zeros */
   ssd_cmd(d, SSD1306_COLUMNADDR);
   ssd_cmd(d, (uint8_t)0 + SGFX_SH110X_COL_OFFSET);
-  ssd_cmd(d, (uint8_t)(s.w-1) + SGFX_SH110X_COL_OFFSET);
+  ssd_cmd(d, (uint8_t)(s->w-1) + SGFX_SH110X_COL_OFFSET);
   ssd_cmd(d, SSD1306_PAGEADDR);
   ssd_cmd(d, 0);
-  ssd_cmd(d, (uint8_t)(s.pages-1));
+  ssd_cmd(d, (uint8_t)(s->pages-1));
   /* send in chunks */
   const size_t CH = 32;
-  for (int off = 0; off < s.fb_bytes; off += (int)CH){
-    size_t n = (size_t)((off + (int)CH <= s.fb_bytes) ? CH : (s.fb_bytes - off));
-    ssd_data(d, s.fb + off, n);
+  for (int off = 0; off < s->fb_bytes; off += (int)CH){
+    size_t n = (size_t)((off + (int)CH <= s->fb_bytes) ? CH : (s->fb_bytes - off));
+    ssd_data(d, s->fb + off, n);
   }
   return SGFX_OK;
 }
@@ -121,43 +154,56 @@ static int ssd_set_rotation(sgfx_device_t* d, uint8_t rot){
   return SGFX_OK;
 }
 
-/* ---- set window for a single page band ---- */
-static int ssd_set_window(sgfx_device_t* d, int x0, int page, int x1){
+/* ---- set window: columns x0..x1, pages p0..p1 ---- */
+static int ssd_set_window(sgfx_device_t* d, int x0, int p0, int x1, int p1){
+  ssd_state_t* s = ssd_of(d);
   if (x0 < 0) x0 = 0;
-  if (x1 > s.w - 1) x1 = s.w - 1;
-  if (page < 0) page = 0;
-  if (page > s.pages - 1) page = s.pages - 1;
+  if (x1 > s->w - 1) x1 = s->w - 1;
+  if (p0 < 0) p0 = 0;
+  if (p1 > s->pages - 1) p1 = s->pages - 1;
 
   int rc = ssd_cmd(d, SSD1306_COLUMNADDR); if (rc) return rc;
   rc = ssd_cmd(d, (uint8_t)x0 + SGFX_SH110X_COL_OFFSET); if (rc) return rc;
   rc = ssd_cmd(d, (uint8_t)x1 + SGFX_SH110X_COL_OFFSET); if (rc) return rc;
 
   rc = ssd_cmd(d, SSD1306_PAGEADDR); if (rc) return rc;
-  rc = ssd_cmd(d, (uint8_t)page);    if (rc) return rc;
-  rc = ssd_cmd(d, (uint8_t)page);    if (rc) return rc;
+  rc = ssd_cmd(d, (uint8_t)p0);      if (rc) return rc;
+  rc = ssd_cmd(d, (uint8_t)p1);      if (rc) return rc;
   return SGFX_OK;
 }
 
+/* Send fb bytes [off, off+n) that the current window expects next. */
+static int ssd_send_fb(sgfx_device_t* d, int off, size_t n){
+  ssd_state_t* s = ssd_of(d);
+  if (s->sent) memcpy(s->sent + off, s->fb + off, n);
+  return ssd_data(d, s->fb + off, n);
+}
+
 /* ---- fb helpers ---- */
-static inline uint8_t* fb_byte(int x, int y){
-  /* page-major: byte index = page*s.w + x; bit = y & 7 */
-  return &s.fb[(y>>3)*s.w + x];
+static inline uint8_t* fb_byte(ssd_state_t* s, int x, int y){
+  /* page-major: byte index = page*s->w + x; bit = y & 7 */
+  return &s->fb[(y>>3)*s->w + x];
 }
 
 /* ---- MONO fill rect with proper bitwise merge ---- */
 static int ssd_fill_rect(sgfx_device_t* d, int x,int y,int w,int h, sgfx_rgba8_t c){
+  ssd_state_t* s = ssd_of(d);
   /* clip */
   int x0 = x, y0 = y;
   int x1 = x + w - 1;
   int y1 = y + h - 1;
   if (x0 < 0) x0 = 0;
   if (y0 < 0) y0 = 0;
-  if (x1 >= s.w)  x1 = s.w - 1;
-  if (y1 >= s.h)  y1 = s.h - 1;
+  if (x1 >= s->w)  x1 = s->w - 1;
+  if (y1 >= s->h)  y1 = s->h - 1;
   if (x1 < x0 || y1 < y0) return SGFX_OK;
 
   /* on = any nonzero RGB -> set bits; black -> clear bits */
   const int set_on = (c.r | c.g | c.b) != 0;
+  /* dithering: grey levels become an ordered pattern (FS uses Bayer 8x8 here) */
+  const int luma = (c.r*77 + c.g*150 + c.b*29) >> 8;
+  const uint8_t bayer = d->dither == SGFX_DITHER_FS ? SGFX_DITHER_BAYER8 : d->dither;
+  const int pattern = d->dither && luma > 0 && luma < 255;
 
   const int page_start = y0 >> 3;
   const int page_end   = y1 >> 3;
@@ -178,54 +224,95 @@ static int ssd_fill_rect(sgfx_device_t* d, int x,int y,int w,int h, sgfx_rgba8_t
     if (cols <= 0) continue;
     /* mutate fb in place */
     for (int xcol = x0; xcol <= x1; ++xcol){
-      uint8_t* p = &s.fb[page*s.w + xcol];
+      uint8_t* p = &s->fb[page*s->w + xcol];
       uint8_t prev = *p;
-      uint8_t next = set_on ? (prev | mask) : (prev & (uint8_t)~mask);
+      uint8_t bits = set_on ? 0xFF : 0x00;
+      if (pattern){
+        bits = 0;
+        for (int b = from; b <= to; ++b)
+          if (luma > (sgfx_bayer(bayer, xcol, band_y0 + b) << 2) + 1) bits |= (uint8_t)(1u << b);
+      }
+      uint8_t next = (uint8_t)((prev & (uint8_t)~mask) | (bits & mask));
       if (next != prev) *p = next;
     }
+  }
 
-    /* push the band sub-rectangle from fb to panel */
-    int rc = ssd_set_window(d, x0, page, x1);
-    if (rc) return rc;
+  if (s->sent) return SGFX_OK;     /* deferred: ssd_present sends the diff */
 
-    /* stream columns straight from fb (already merged) */
-    const uint8_t* row = &s.fb[page*s.w + x0];
-    rc = ssd_data(d, row, (size_t)cols);
+  /* one window over all pages; data wraps to the next page at x1 */
+  int rc = ssd_set_window(d, x0, page_start, x1, page_end);
+  if (rc) return rc;
+  for (int page = page_start; page <= page_end; ++page){
+    rc = ssd_data(d, &s->fb[page*s->w + x0], (size_t)(x1 - x0 + 1));
     if (rc) return rc;
   }
   return SGFX_OK;
 }
 
-/* full present: flush entire framebuffer (optional) */
+/* Deferred: per page, send the spans that differ from s->sent. Spans closer
+ * than SGFX_SSD1306_SPAN_GAP are merged into one window. */
+static int ssd_present_diff(sgfx_device_t* d){
+  ssd_state_t* s = ssd_of(d);
+  for (int page = 0; page < s->pages; ++page){
+    const uint8_t* a = s->fb + page*s->w;
+    const uint8_t* b = s->sent + page*s->w;
+    int x = 0;
+    while (x < s->w){
+      while (x < s->w && a[x] == b[x]) x++;
+      if (x == s->w) break;
+      int x0 = x, x1 = x;
+      for (++x; x < s->w; ++x){
+        if (a[x] == b[x]) continue;
+        if (x - x1 - 1 > SGFX_SSD1306_SPAN_GAP) break;
+        x1 = x;
+      }
+      int rc = ssd_set_window(d, x0, page, x1, page); if (rc) return rc;
+      rc = ssd_send_fb(d, page*s->w + x0, (size_t)(x1 - x0 + 1)); if (rc) return rc;
+    }
+  }
+  return SGFX_OK;
+}
+
+/* full present: flush entire framebuffer (deferred mode: only what changed) */
 static int ssd_present(sgfx_device_t* d){
-  int rc = ssd_cmd(d, SSD1306_COLUMNADDR); if (rc) return rc;
-  rc = ssd_cmd(d, (uint8_t)0 + SGFX_SH110X_COL_OFFSET); if (rc) return rc;
-  rc = ssd_cmd(d, (uint8_t)(s.w-1) + SGFX_SH110X_COL_OFFSET); if (rc) return rc;
-  rc = ssd_cmd(d, SSD1306_PAGEADDR); if (rc) return rc;
-  rc = ssd_cmd(d, 0); if (rc) return rc;
-  rc = ssd_cmd(d, (uint8_t)(s.pages-1)); if (rc) return rc;
+  ssd_state_t* s = ssd_of(d);
+  if (s->sent) return ssd_present_diff(d);
+  int rc = ssd_set_window(d, 0, 0, s->w - 1, s->pages - 1); if (rc) return rc;
 
   /* stream the whole fb */
   const size_t CH = 64;
-  for (int off = 0; off < s.fb_bytes; off += (int)CH){
-    size_t n = (size_t)((off + (int)CH <= s.fb_bytes) ? CH : (s.fb_bytes - off));
-    rc = ssd_data(d, s.fb + off, n);
+  for (int off = 0; off < s->fb_bytes; off += (int)CH){
+    size_t n = (size_t)((off + (int)CH <= s->fb_bytes) ? CH : (s->fb_bytes - off));
+    rc = ssd_data(d, s->fb + off, n);
     if (rc) return rc;
   }
   return SGFX_OK;
 }
 
-
-/* ---- compat: rectangular set_window + RGB565 write_pixels for SGFX FB ---- */
-/* We don't program the panel window here; we'll patch s.fb per row then stream that page */
+/* ---- rectangular set_window + write_pixels for the SGFX presenter ----
+ * RGB565: we don't program the panel window here; each row is patched into
+ * s->fb and its page streamed. MONO1: page bytes (column bytes of page p0,
+ * then p1, ...) for the window widened to whole pages; one panel window per
+ * rect, programmed on the first write. */
 static int ssd_set_window_rect(sgfx_device_t* d, int x,int y,int w,int h){
-  (void)d;
+  ssd_state_t* s = ssd_of(d);
   if (x < 0) x = 0;
   if (y < 0) y = 0;
-  if (x + w > s.w) w = s.w - x;
-  if (y + h > s.h) h = s.h - y;
-  s.win_x = x; s.win_y = y; s.win_w = w; s.win_h = h;
-  s.cur_col = 0; s.cur_row = 0;
+  if (x + w > s->w) w = s->w - x;
+  if (y + h > s->h) h = s->h - y;
+  s->win_x = x; s->win_y = y; s->win_w = w; s->win_h = h;
+  s->cur_col = 0; s->cur_row = 0;
+  s->win_sent = 0;
+
+  s->dt.mode = d->dither;
+  if (s->dt.mode == SGFX_DITHER_FS && w > 0){
+    if (s->dt.err_cap < w){
+      int16_t* e = (int16_t*)realloc(s->dt.err, (size_t)w * sizeof(int16_t));
+      if (!e) s->dt.mode = SGFX_DITHER_BAYER8;       /* no RAM: ordered instead */
+      else { s->dt.err = e; s->dt.err_cap = w; }
+    }
+    if (s->dt.mode == SGFX_DITHER_FS) memset(s->dt.err, 0, (size_t)w * sizeof(int16_t));
+  }
   return SGFX_OK;
 }
 
@@ -235,45 +322,106 @@ static inline int mono_from_rgb565(uint16_t p){
   return p != 0;
 }
 
-/* Stream of RGB565 words comes row-by-row; we merge into s.fb then push that page band */
+/* Same with dithering on luma; col is the window column (FS error slot). */
+static inline int mono_dither(ssd_state_t* s, uint16_t p, int x, int y, int col){
+  int l = sgfx_luma565(p);
+  if (s->dt.mode != SGFX_DITHER_FS) return l > (sgfx_bayer(s->dt.mode, x, y) << 2) + 1;
+  if (!col) sgfx_fs_row_start(&s->dt);
+  int v = sgfx_fs_in(&s->dt, 1, 0, col, l);
+  int on = v >= 128;
+  sgfx_fs_out(&s->dt, 1, 0, col, v - (on ? 255 : 0));
+  return on;
+}
+
+/* Page bytes straight from a MONO1 fb: copy into s->fb, send as is.
+ * cur_row counts pages here. */
+static int ssd_write_pages(sgfx_device_t* d, const uint8_t* src, size_t count){
+  ssd_state_t* s = ssd_of(d);
+  const int p0 = s->win_y >> 3, p1 = (s->win_y + s->win_h - 1) >> 3;
+  if (s->win_w <= 0 || s->win_h <= 0) return SGFX_OK;
+  if (!s->win_sent){
+    int rc = ssd_set_window(d, s->win_x, p0, s->win_x + s->win_w - 1, p1);
+    if (rc) return rc;
+    s->win_sent = 1;
+  }
+  size_t left = count;
+  const uint8_t* b = src;
+  while (left && p0 + s->cur_row <= p1){
+    size_t n = (size_t)(s->win_w - s->cur_col);
+    if (n > left) n = left;
+    int off = (p0 + s->cur_row)*s->w + s->win_x + s->cur_col;
+    memcpy(&s->fb[off], b, n);
+    if (s->sent) memcpy(&s->sent[off], b, n);
+    b += n; left -= n;
+    s->cur_col += (int)n;
+    if (s->cur_col == s->win_w){ s->cur_col = 0; s->cur_row++; }
+  }
+  return ssd_data(d, src, (size_t)(b - src));
+}
+
+/* Send one page of the window from s->fb. Pages complete top to bottom, so
+ * the window covering all of them is set on the first flush and the data of
+ * later pages simply continues (horizontal addressing wraps at x1). */
+static int ssd_flush_page(sgfx_device_t* d, int page){
+  ssd_state_t* s = ssd_of(d);
+  const int x0 = s->win_x, x1 = s->win_x + s->win_w - 1;
+  if (!s->win_sent){
+    int rc = ssd_set_window(d, x0, page, x1, (s->win_y + s->win_h - 1) >> 3);
+    if (rc) return rc;
+    s->win_sent = 1;
+  }
+  return ssd_send_fb(d, page*s->w + x0, (size_t)(x1 - x0 + 1));
+}
+
+/* Stream of RGB565 words comes row-by-row; rows are merged into s->fb and each
+ * page band is pushed once it is complete (or the window ends) */
 static int ssd_write_pixels_rect(sgfx_device_t* d, const void* src, size_t count, sgfx_pixfmt_t fmt){
+  ssd_state_t* s = ssd_of(d);
+  if (fmt == SGFX_FMT_MONO1) return ssd_write_pages(d, (const uint8_t*)src, count);
   if (fmt != SGFX_FMT_RGB565) return SGFX_ERR_NOSUP;
   const uint16_t* px = (const uint16_t*)src;
   size_t i = 0;
   while (i < count){
-    int x = s.win_x + s.cur_col;
-    int y = s.win_y + s.cur_row;
-    if (x < 0 || x >= s.w || y < 0 || y >= s.h) {
+    int x = s->win_x + s->cur_col;
+    int y = s->win_y + s->cur_row;
+    if (x < 0 || x >= s->w || y < 0 || y >= s->h) {
       /* skip but keep advancing to avoid infinite loop */
     } else {
-      uint8_t* fbbyte = &s.fb[(y>>3)*s.w + x];
+      uint8_t* fbbyte = &s->fb[(y>>3)*s->w + x];
       uint8_t mask = (uint8_t)(1u << (y & 7));
-      if (mono_from_rgb565(px[i])) *fbbyte |=  mask;
+      int on = s->dt.mode ? mono_dither(s, px[i], x, y, s->cur_col) : mono_from_rgb565(px[i]);
+      if (on) *fbbyte |=  mask;
       else                         *fbbyte &= (uint8_t)~mask;
     }
-    s.cur_col++;
+    s->cur_col++;
     i++;
-    if (s.cur_col >= s.win_w){
-      /* end of row: push this row's page bytes */
-      int page = (s.win_y + s.cur_row) >> 3;
-      int x0 = s.win_x;
-      int x1 = s.win_x + s.win_w - 1;
-      int rc = ssd_set_window(d, x0, page, x1);
-      if (rc) return rc;
-      const uint8_t* row = &s.fb[page*s.w + x0];
-      rc = ssd_data(d, row, (size_t)(x1 - x0 + 1));
-      if (rc) return rc;
-      s.cur_col = 0;
-      s.cur_row++;
-      if (s.cur_row >= s.win_h){
+    if (s->cur_col >= s->win_w){
+      /* end of row: a page goes out once, when its last window row is in */
+      s->cur_col = 0;
+      s->cur_row++;
+      if ((y & 7) == 7 || s->cur_row >= s->win_h){
+        int rc = ssd_flush_page(d, y >> 3);
+        if (rc) return rc;
+      }
+      if (s->cur_row >= s->win_h){
         /* rectangle complete */
-        s.cur_row = s.cur_col = 0;
+        s->cur_row = s->cur_col = 0;
         break;
       }
     }
   }
   return SGFX_OK;
 }
+static void ssd_deinit(sgfx_device_t* d){
+  ssd_state_t* s = ssd_of(d);
+  if (!s) return;
+  if (s->owns_fb) free(s->fb);
+  if (s->owns_sent) free(s->sent);
+  free(s->dt.err);
+  free(s);
+  d->drv_state = NULL;
+}
+
 /* ---- driver ops ---- */
 const sgfx_driver_ops_t sgfx_ssd1306_ops = {
   .init = ssd_init,
@@ -285,7 +433,8 @@ const sgfx_driver_ops_t sgfx_ssd1306_ops = {
   .power = NULL,
   .invert = NULL,
   .brightness = NULL,
-  .present = ssd_present
+  .present = ssd_present,
+  .deinit = ssd_deinit
 };
 
 /* advertise caps */
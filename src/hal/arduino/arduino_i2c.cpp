@@ -5,6 +5,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <string.h>
+#include <new>
 
 typedef struct {
     TwoWire* wire;
@@ -26,7 +27,7 @@ static int i2c_begin(sgfx_bus_t* b){
   if (s->pin_bl  >=0){ pinMode(s->pin_bl, OUTPUT);  digitalWrite(s->pin_bl, HIGH); }
   return SGFX_OK;
 }
-static void i2c_end(sgfx_bus_t* b){ (void)b; }
+static void i2c_end(sgfx_bus_t* b){ delete (i2c_bus_t*)b->user; b->user = NULL; }
 
 static int i2c_write_cmd(sgfx_bus_t* b, uint8_t cmd){
     i2c_bus_t* s=(i2c_bus_t*)b->user;
@@ -85,17 +86,19 @@ static const sgfx_bus_ops_t VOPS = {
 };
 
 extern "C" int sgfx_hal_make_i2c(sgfx_bus_t* out, const sgfx_hal_cfg_i2c_t* cfg){
-    static i2c_bus_t state;
-  memset(&state, 0, sizeof state);
-  state.addr = cfg->addr ? cfg->addr : 0x3C;
-  state.pin_sda = cfg->pin_sda;
-  state.pin_scl = cfg->pin_scl;
-  state.pin_rst = cfg->pin_rst;
-  state.pin_bl  = cfg->pin_bl;
-  state.hz = cfg->hz ? cfg->hz : 400000;
+  /* one state per bus: cfg->port (TwoWire*) or Wire */
+  i2c_bus_t* state = new (std::nothrow) i2c_bus_t();
+  if (!state) return SGFX_ERR_NOMEM;
+  state->wire = (TwoWire*)cfg->port;
+  state->addr = cfg->addr ? cfg->addr : 0x3C;
+  state->pin_sda = cfg->pin_sda;
+  state->pin_scl = cfg->pin_scl;
+  state->pin_rst = cfg->pin_rst;
+  state->pin_bl  = cfg->pin_bl;
+  state->hz = cfg->hz ? cfg->hz : 400000;
   out->ops = &VOPS;
-  out->user = &state;
-  out->hz_max = state.hz;
+  out->user = state;
+  out->hz_max = state->hz;
   out->features = 0;
   return SGFX_OK;
 }
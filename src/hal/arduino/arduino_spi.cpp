@@ -8,6 +8,7 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <string.h>
+#include <new>
 
 typedef struct {
     SPIClass* spi;
@@ -15,14 +16,15 @@ typedef struct {
   int8_t pin_cs, pin_dc, pin_rst, pin_bl;
   uint32_t hz;
   SPISettings settings;
+  uint16_t rep[256];        /* write_repeat pattern */
 } spi_bus_t;
 
 
 static int spi_begin(sgfx_bus_t* b){
   spi_bus_t* s = (spi_bus_t*)b->user;
 
-  // Use the global SPI object on all ESP32 variants (S3/C3/C6 + classic)
-  s->spi = &SPI;
+  // cfg->port, else the global SPI object (ESP32 S3/C3/C6 + classic)
+  if (!s->spi) s->spi = &SPI;
 
   // Map pins and initialize
   int sck  = (s->pin_sck  >= 0) ? s->pin_sck  : SCK;
@@ -45,7 +47,9 @@ static int spi_begin(sgfx_bus_t* b){
 }
 
 static void spi_end(sgfx_bus_t* b){
-    (void)b; /* keep bus alive */
+  /* SPIClass stays up: other panels may share it */
+  delete (spi_bus_t*)b->user;
+  b->user = NULL;
 }
 
 static inline void cs_low(const spi_bus_t* s){ if (s->pin_cs >= 0) digitalWrite(s->pin_cs, LOW); }
@@ -82,17 +86,37 @@ static int spi_write_data(sgfx_bus_t* b, const void* buf, size_t len){
   return SGFX_OK;
 }
 
+/* Init runs: CS stays low across the whole run, DC drops for each opcode. */
+static int spi_write_cmds(sgfx_bus_t* b, const uint8_t* seq, size_t len){
+    spi_bus_t* s = (spi_bus_t*)b->user;
+  s->spi->beginTransaction(s->settings);
+  cs_low(s);
+  for (size_t i = 0; i + 1 < len; i += 2u + seq[i+1]){
+    if (s->pin_dc >= 0) digitalWrite(s->pin_dc, LOW);
+    s->spi->transfer(seq[i]);
+    if (s->pin_dc >= 0) digitalWrite(s->pin_dc, HIGH);
+#if defined(ESP32)
+    if (seq[i+1]) s->spi->writeBytes(seq + i + 2, seq[i+1]);
+#else
+    for (uint8_t k = 0; k < seq[i+1]; ++k) s->spi->transfer(seq[i+2+k]);
+#endif
+  }
+  cs_high(s);
+  s->spi->endTransaction();
+  return SGFX_OK;
+}
+
 static int spi_write_repeat(sgfx_bus_t* b, const void* unit, size_t unit_bytes, size_t count){
     spi_bus_t* s = (spi_bus_t*)b->user;
   if (unit_bytes != 2) return SGFX_ERR_NOSUP; /* RGB565 */
   const uint16_t v = *(const uint16_t*)unit;
-  static uint16_t cache[256];
-  for (size_t i=0;i<sizeof(cache)/sizeof(cache[0]);++i) cache[i]=v;
+  uint16_t* cache = s->rep;
+  for (size_t i=0;i<sizeof(s->rep)/sizeof(s->rep[0]);++i) cache[i]=v;
 
   s->spi->beginTransaction(s->settings);
   cs_low(s);
   while (count){
-      size_t n = count > (sizeof(cache)/sizeof(cache[0])) ? (sizeof(cache)/sizeof(cache[0])) : count;
+      size_t n = count > (sizeof(s->rep)/sizeof(s->rep[0])) ? (sizeof(s->rep)/sizeof(s->rep[0])) : count;
     s->spi->writeBytes((const uint8_t*)cache, n*2);
     count -= n;
   }
@@ -136,24 +160,27 @@ static const sgfx_bus_ops_t VOPS = {
     .begin = spi_begin, .end = spi_end,
   .write_cmd = spi_write_cmd, .write_data = spi_write_data,
   .write_repeat = spi_write_repeat, .write_pixels = spi_write_pixels,
-  .read_data = spi_read_data, .delay_ms = spi_delay, .gpio_set = spi_gpio_set
+  .read_data = spi_read_data, .delay_ms = spi_delay, .gpio_set = spi_gpio_set,
+  .write_cmds = spi_write_cmds
 };
 
 extern "C" int sgfx_hal_make_spi(sgfx_bus_t* out, const sgfx_hal_cfg_spi_t* cfg){
-    static spi_bus_t state;
-  memset(&state, 0, sizeof state);
-  state.pin_sck = cfg->pin_sck;
-  state.pin_mosi = cfg->pin_mosi;
-  state.pin_miso = cfg->pin_miso;
-  state.pin_cs = cfg->pin_cs;
-  state.pin_dc = cfg->pin_dc;
-  state.pin_rst = cfg->pin_rst;
-  state.pin_bl = cfg->pin_bl;
-  state.hz = cfg->hz ? cfg->hz : 40000000;
+  /* one state per bus: several panels must not share pins or settings */
+  spi_bus_t* state = new (std::nothrow) spi_bus_t();
+  if (!state) return SGFX_ERR_NOMEM;
+  state->spi = (SPIClass*)cfg->port;
+  state->pin_sck = cfg->pin_sck;
+  state->pin_mosi = cfg->pin_mosi;
+  state->pin_miso = cfg->pin_miso;
+  state->pin_cs = cfg->pin_cs;
+  state->pin_dc = cfg->pin_dc;
+  state->pin_rst = cfg->pin_rst;
+  state->pin_bl = cfg->pin_bl;
+  state->hz = cfg->hz ? cfg->hz : 40000000;
   out->ops = &VOPS;
-  out->user = &state;
-  out->hz_max = state.hz;
-  out->features = 0;
+  out->user = state;
+  out->hz_max = state->hz;
+  out->features = cfg->pin_rst >= 0 ? SGFX_BUS_HW_RESET : 0;
   return SGFX_OK;
 }
 #endif
@@ -2,6 +2,7 @@
 
 #include "sgfx_hal.h"
 #include "sgfx.h"
+#include <stdlib.h>
 #include <string.h>
 #include "driver/i2c.h"
 #include "driver/gpio.h"
@@ -17,11 +18,12 @@
 #endif
 
 typedef struct {
+  i2c_port_t port;
   uint8_t addr;
 } idf_i2c_ctx_t;
 
 static int idf_begin(sgfx_bus_t* b){ return SGFX_OK; }
-static void idf_end(sgfx_bus_t* b){ (void)b; }
+static void idf_end(sgfx_bus_t* b){ free(b->user); b->user = NULL; }
 
 static inline void idf_delay(sgfx_bus_t* b, uint32_t ms){
   (void)b;
@@ -36,7 +38,7 @@ static inline void idf_gpio_set(sgfx_bus_t* b, int pin_id, bool level){
 static int idf_write_cmd(sgfx_bus_t* b, uint8_t cmd){
   idf_i2c_ctx_t* c = (idf_i2c_ctx_t*)b->user;
   uint8_t buf[2] = {0x00, cmd}; // control byte = 0x00 for commands
-  esp_err_t err = i2c_master_write_to_device(SGFX_IDF_I2C_PORT, c->addr, buf, 2, 100/portTICK_PERIOD_MS);
+  esp_err_t err = i2c_master_write_to_device(c->port, c->addr, buf, 2, 100/portTICK_PERIOD_MS);
   return (err==ESP_OK)?SGFX_OK:-1;
 }
 
@@ -51,7 +53,7 @@ static int idf_write_data(sgfx_bus_t* b, const void* buf, size_t len){
     if (n > sizeof(temp)-1) n = sizeof(temp)-1;
     temp[0] = 0x40;
     memcpy(&temp[1], p, n);
-    esp_err_t err = i2c_master_write_to_device(SGFX_IDF_I2C_PORT, c->addr, temp, n+1, 100/portTICK_PERIOD_MS);
+    esp_err_t err = i2c_master_write_to_device(c->port, c->addr, temp, n+1, 100/portTICK_PERIOD_MS);
     if (err != ESP_OK) return -1;
     p += n; len -= n;
   }
@@ -101,11 +103,13 @@ int sgfx_hal_make_i2c(sgfx_bus_t* out, const sgfx_hal_cfg_i2c_t* cfg){
     .scl_pullup_en = GPIO_PULLUP_ENABLE,
     .master.clk_speed = cfg->hz
   };
-  if (i2c_param_config(SGFX_IDF_I2C_PORT, &conf) != ESP_OK) return -1;
-  if (i2c_driver_install(SGFX_IDF_I2C_PORT, conf.mode, 0, 0, 0) != ESP_OK) return -1;
+  i2c_port_t port = cfg->port ? (i2c_port_t)SGFX_HAL_PORT_INDEX(cfg->port) : SGFX_IDF_I2C_PORT;
+  if (i2c_param_config(port, &conf) != ESP_OK) return -1;
+  if (i2c_driver_install(port, conf.mode, 0, 0, 0) != ESP_OK) return -1;
 
   idf_i2c_ctx_t* c = (idf_i2c_ctx_t*)calloc(1, sizeof(*c));
   if (!c) return -1;
+  c->port = port;
   c->addr = cfg->addr;
 
   out->ops = &IDF_I2C_OPS;
@@ -2,9 +2,12 @@
 
 #include "sgfx_hal.h"
 #include "sgfx.h"
+#include <stdlib.h>
 #include <string.h>
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -19,14 +22,54 @@
   #endif
 #endif
 
+/* Transactions kept in the driver queue (also the write_data_async depth) */
+#ifndef SGFX_IDF_SPI_QUEUE
+#define SGFX_IDF_SPI_QUEUE 7
+#endif
+/* Bus max_transfer_sz; longer writes are split into queued chunks */
+#ifndef SGFX_IDF_SPI_MAX_XFER
+#define SGFX_IDF_SPI_MAX_XFER 32768
+#endif
+/* DMA-capable pattern buffer for write_repeat */
+#ifndef SGFX_IDF_SPI_REPEAT_BYTES
+#define SGFX_IDF_SPI_REPEAT_BYTES 1024
+#endif
+/* Data writes up to this size go out as polling transactions (from the
+ * 4-byte spi_transaction_t.tx_data, so 4 at most) */
+#ifndef SGFX_IDF_SPI_POLL_BYTES
+#define SGFX_IDF_SPI_POLL_BYTES 4
+#endif
+#if SGFX_IDF_SPI_POLL_BYTES < 0 || SGFX_IDF_SPI_POLL_BYTES > 4
+# error "SGFX_IDF_SPI_POLL_BYTES must be 0..4 (spi_transaction_t.tx_data)"
+#endif
+
 typedef struct {
   spi_device_handle_t dev;
   int pin_dc, pin_rst, pin_bl;
   uint32_t hz;
+  size_t max_xfer;
+
+  /* queued transactions complete in order; slots are reused as a ring */
+  spi_transaction_t trans[SGFX_IDF_SPI_QUEUE];
+  int head, pending;
+
+  /* write_data_async calls still in flight: transactions left per call */
+  uint8_t calls[SGFX_IDF_SPI_QUEUE];
+  int call_head, ncalls;
+
+  uint8_t* rep;          /* DMA-capable, filled with whole units */
+  size_t   rep_unit;     /* unit size the pattern was built for */
 } idf_spi_ctx_t;
 
-static int idf_begin(sgfx_bus_t* b){ return SGFX_OK; }
-static void idf_end(sgfx_bus_t* b){ (void)b; }
+/* DC level travels in t->user as (pin << 1 | level); -1 leaves DC alone */
+#define IDF_DC_TAG(c, lvl) ((void*)(intptr_t)((c)->pin_dc >= 0 ? (((c)->pin_dc << 1) | (lvl)) : -1))
+
+static void IRAM_ATTR idf_pre_cb(spi_transaction_t* t){
+  int v = (int)(intptr_t)t->user;
+  if (v >= 0) gpio_set_level(v >> 1, v & 1);
+}
+
+static int idf_begin(sgfx_bus_t* b){ (void)b; return SGFX_OK; }
 
 static inline void idf_delay(sgfx_bus_t* b, uint32_t ms){
   (void)b;
@@ -47,35 +90,129 @@ static inline void idf_gpio_set(sgfx_bus_t* b, int pin_id, bool level){
   }
 }
 
-static int idf_tx_cmddata(spi_device_handle_t dev, const void* data, size_t len, int dc_level){
-  spi_transaction_t t = {0};
-  t.flags = 0;
+/* Collect the oldest queued transaction and credit it to its async call. */
+static int idf_reap(idf_spi_ctx_t* c){
+  spi_transaction_t* t;
+  if (spi_device_get_trans_result(c->dev, &t, portMAX_DELAY) != ESP_OK) return SGFX_ERR_EIO;
+  c->head = (c->head + 1) % SGFX_IDF_SPI_QUEUE;
+  c->pending--;
+  for (int i = 0; i < c->ncalls; ++i){
+    uint8_t* left = &c->calls[(c->call_head + i) % SGFX_IDF_SPI_QUEUE];
+    if (*left){ (*left)--; break; }
+  }
+  return SGFX_OK;
+}
+
+static int idf_queue(idf_spi_ctx_t* c, const void* data, size_t len, int dc_level){
+  if (c->pending == SGFX_IDF_SPI_QUEUE){ int rc = idf_reap(c); if (rc) return rc; }
+  spi_transaction_t* t = &c->trans[(c->head + c->pending) % SGFX_IDF_SPI_QUEUE];
+  memset(t, 0, sizeof(*t));
+  t->length = len * 8;
+  t->tx_buffer = data;
+  t->user = IDF_DC_TAG(c, dc_level);
+  if (spi_device_queue_trans(c->dev, t, portMAX_DELAY) != ESP_OK) return SGFX_ERR_EIO;
+  c->pending++;
+  return SGFX_OK;
+}
+
+/* Wait for every queued transaction (async calls included). */
+static int idf_drain(idf_spi_ctx_t* c){
+  while (c->pending){ int rc = idf_reap(c); if (rc) return rc; }
+  c->ncalls = 0;
+  return SGFX_OK;
+}
+
+/* The host stays initialised: other panels may share it. */
+static void idf_end(sgfx_bus_t* b){
+  idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
+  if (!c) return;
+  idf_drain(c);
+  spi_bus_remove_device(c->dev);
+  heap_caps_free(c->rep);
+  free(c);
+  b->user = NULL;
+}
+
+/* Queue len bytes in max_xfer chunks; returns the number of transactions or <0. */
+static int idf_queue_chunked(idf_spi_ctx_t* c, const uint8_t* p, size_t len, int dc_level){
+  int n = 0;
+  while (len){
+    size_t k = len > c->max_xfer ? c->max_xfer : len;
+    int rc = idf_queue(c, p, k, dc_level);
+    if (rc) return rc;
+    p += k; len -= k; n++;
+  }
+  return n;
+}
+
+/* Short writes: polling transmit from tx_data, no interrupt/queue round trip.
+ * Polling may not overlap queued transactions, so drain first. */
+static int idf_poll(idf_spi_ctx_t* c, const void* data, size_t len, int dc_level){
+  int rc = idf_drain(c);
+  if (rc) return rc;
+  spi_transaction_t t;
+  memset(&t, 0, sizeof(t));
+  t.flags = SPI_TRANS_USE_TXDATA;
   t.length = len * 8;
-  t.tx_buffer = data;
-  // DC pin handled out of band via gpio_set
-  esp_err_t err = spi_device_transmit(dev, &t);
-  return (err==ESP_OK) ? SGFX_OK : -1;
+  memcpy(t.tx_data, data, len);
+  t.user = IDF_DC_TAG(c, dc_level);
+  return (spi_device_polling_transmit(c->dev, &t) == ESP_OK) ? SGFX_OK : SGFX_ERR_EIO;
 }
 
 static int idf_write_cmd(sgfx_bus_t* b, uint8_t cmd){
-  idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
-  if (c->pin_dc >= 0) gpio_set_level(c->pin_dc, 0);
-  return idf_tx_cmddata(c->dev, &cmd, 1, 0);
+  return idf_poll((idf_spi_ctx_t*)b->user, &cmd, 1, 0);
 }
 
 static int idf_write_data(sgfx_bus_t* b, const void* buf, size_t len){
   idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
-  if (c->pin_dc >= 0) gpio_set_level(c->pin_dc, 1);
-  return idf_tx_cmddata(c->dev, buf, len, 1);
+  if (!len) return SGFX_OK;
+  if (len <= SGFX_IDF_SPI_POLL_BYTES) return idf_poll(c, buf, len, 1);
+  int rc = idf_drain(c);
+  if (rc) return rc;
+  rc = idf_queue_chunked(c, (const uint8_t*)buf, len, 1);
+  if (rc < 0) return rc;
+  return idf_drain(c);   /* caller owns buf again on return */
+}
+
+/* Init runs: every opcode and argument block queued back to back, one wait
+ * at the end instead of a polling round trip per command. */
+static int idf_write_cmds(sgfx_bus_t* b, const uint8_t* seq, size_t len){
+  idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
+  int rc = idf_drain(c);
+  for (size_t i = 0; !rc && i + 1 < len; i += 2u + seq[i+1]){
+    rc = idf_queue(c, seq + i, 1, 0);
+    if (!rc && seq[i+1]) rc = idf_queue(c, seq + i + 2, seq[i+1], 1);
+  }
+  int rd = idf_drain(c);
+  return rc ? rc : rd;
 }
 
 static int idf_write_repeat(sgfx_bus_t* b, const void* unit, size_t unit_bytes, size_t count){
-  // naive loop; could be optimized with a small cache buffer
-  for (size_t i=0;i<count;i++){
-    int rc = idf_write_data(b, unit, unit_bytes);
+  idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
+  if (!unit || !unit_bytes) return SGFX_ERR_INVAL;
+  if (!count) return SGFX_OK;
+  int rc = idf_drain(c);                       /* rep may still be on the wire */
+  if (rc) return rc;
+  if (!c->rep || unit_bytes > SGFX_IDF_SPI_REPEAT_BYTES){
+    for (size_t i=0;i<count;i++){
+      rc = idf_write_data(b, unit, unit_bytes);
+      if (rc) return rc;
+    }
+    return SGFX_OK;
+  }
+  size_t per = SGFX_IDF_SPI_REPEAT_BYTES / unit_bytes;
+  if (c->rep_unit != unit_bytes || memcmp(c->rep, unit, unit_bytes) != 0){
+    for (size_t i=0;i<per;i++) memcpy(c->rep + i*unit_bytes, unit, unit_bytes);
+    c->rep_unit = unit_bytes;
+  }
+  /* the same read-only buffer can sit in the queue many times over */
+  while (count){
+    size_t n = count > per ? per : count;
+    rc = idf_queue(c, c->rep, n * unit_bytes, 1);
     if (rc) return rc;
+    count -= n;
   }
-  return SGFX_OK;
+  return idf_drain(c);
 }
 
 static int idf_write_pixels(sgfx_bus_t* b, const void* px, size_t count, sgfx_pixfmt_t src_fmt){
@@ -87,6 +224,34 @@ static int idf_write_pixels(sgfx_bus_t* b, const void* px, size_t count, sgfx_pi
   return idf_write_data(b, px, count*2);
 }
 
+static int idf_write_data_async(sgfx_bus_t* b, const void* buf, size_t len){
+  idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
+  if (!len) return SGFX_ERR_INVAL;
+  if (c->ncalls == SGFX_IDF_SPI_QUEUE) return SGFX_ERR_EIO;
+  int slot = (c->call_head + c->ncalls) % SGFX_IDF_SPI_QUEUE;
+  c->calls[slot] = 0;
+  c->ncalls++;
+  /* count as we go: idf_queue may reap older calls' transactions meanwhile */
+  const uint8_t* p = (const uint8_t*)buf;
+  while (len){
+    size_t k = len > c->max_xfer ? c->max_xfer : len;
+    int rc = idf_queue(c, p, k, 1);
+    if (rc) return rc;
+    c->calls[slot]++;
+    p += k; len -= k;
+  }
+  return SGFX_OK;
+}
+
+static int idf_wait_async(sgfx_bus_t* b){
+  idf_spi_ctx_t* c = (idf_spi_ctx_t*)b->user;
+  if (!c->ncalls) return SGFX_OK;
+  while (c->calls[c->call_head]){ int rc = idf_reap(c); if (rc) return rc; }
+  c->call_head = (c->call_head + 1) % SGFX_IDF_SPI_QUEUE;
+  c->ncalls--;
+  return SGFX_OK;
+}
+
 static int idf_read_data(sgfx_bus_t* b, void* buf, size_t len){
   (void)b; (void)buf; (void)len;
   return -1; // not implemented
@@ -101,7 +266,10 @@ static const sgfx_bus_ops_t IDF_SPI_OPS = {
   .write_pixels = idf_write_pixels,
   .read_data = idf_read_data,
   .delay_ms = idf_delay,
-  .gpio_set = idf_gpio_set
+  .gpio_set = idf_gpio_set,
+  .write_data_async = idf_write_data_async,
+  .wait_async = idf_wait_async,
+  .write_cmds = idf_write_cmds
 };
 
 int sgfx_hal_make_spi(sgfx_bus_t* out, const sgfx_hal_cfg_spi_t* cfg){
@@ -119,28 +287,35 @@ int sgfx_hal_make_spi(sgfx_bus_t* out, const sgfx_hal_cfg_spi_t* cfg){
     .sclk_io_num = cfg->pin_sck,
     .quadwp_io_num = -1,
     .quadhd_io_num = -1,
-    .max_transfer_sz = 4096
+    .max_transfer_sz = SGFX_IDF_SPI_MAX_XFER
   };
-  if (spi_bus_initialize(SGFX_IDF_SPI_HOST, &buscfg, SPI_DMA_CH_AUTO) != ESP_OK) return -1;
+  // cfg->port picks the host; a host already set up by another panel is shared
+  spi_host_device_t host = cfg->port ? (spi_host_device_t)SGFX_HAL_PORT_INDEX(cfg->port) : SGFX_IDF_SPI_HOST;
+  esp_err_t err = spi_bus_initialize(host, &buscfg, SPI_DMA_CH_AUTO);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return -1;
 
   spi_device_interface_config_t devcfg = {
     .clock_speed_hz = (int)cfg->hz,
     .mode = 0,
     .spics_io_num = cfg->pin_cs,
-    .queue_size = 1,
+    .queue_size = SGFX_IDF_SPI_QUEUE,
+    .pre_cb = idf_pre_cb,          // DC follows each transaction
   };
   spi_device_handle_t dev;
-  if (spi_bus_add_device(SGFX_IDF_SPI_HOST, &devcfg, &dev) != ESP_OK) return -1;
+  if (spi_bus_add_device(host, &devcfg, &dev) != ESP_OK) return -1;
 
   idf_spi_ctx_t* c = (idf_spi_ctx_t*)calloc(1, sizeof(*c));
   if (!c) return -1;
   c->dev = dev; c->pin_dc = cfg->pin_dc; c->pin_rst = cfg->pin_rst; c->pin_bl = cfg->pin_bl; c->hz = cfg->hz;
+  c->max_xfer = SGFX_IDF_SPI_MAX_XFER;
+  // Optional: without it write_repeat degrades to one write per unit
+  c->rep = (uint8_t*)heap_caps_malloc(SGFX_IDF_SPI_REPEAT_BYTES, MALLOC_CAP_DMA);
 
   out->ops = &IDF_SPI_OPS;
   out->user = c;
   out->hz_max = cfg->hz;
-  out->features = 0;
+  out->features = cfg->pin_rst >= 0 ? SGFX_BUS_HW_RESET : 0;
   return SGFX_OK;
 }
 
-#endif /* SGFX_HAL_ESPIDF */
\ No newline at end of file
+#endif /* SGFX_HAL_ESPIDF */
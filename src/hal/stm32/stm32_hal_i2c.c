@@ -2,10 +2,12 @@
 
 #include "sgfx_hal.h"
 #include "sgfx.h"
+#include <stdlib.h>
 #include <string.h>
 #include "stm32_hal.h" /* see note in stm32_hal_spi.c */
 
 typedef struct {
+  I2C_HandleTypeDef* i2c;   /* cfg->port, else &hi2c_sgfx */
   uint8_t addr;
 } stm_i2c_ctx_t;
 
@@ -13,16 +15,16 @@ extern I2C_HandleTypeDef hi2c_sgfx;
 extern void sgfx_delay_ms(uint32_t ms);
 
 static int stm_begin(sgfx_bus_t* b){ return SGFX_OK; }
-static void stm_end(sgfx_bus_t* b){ (void)b; }
+static void stm_end(sgfx_bus_t* b){ free(b->user); b->user = NULL; }
 static inline void stm_delay(sgfx_bus_t* b, uint32_t ms){ (void)b; sgfx_delay_ms(ms); }
 static inline void stm_gpio_set(sgfx_bus_t* b, int pin_id, bool level){ (void)b; (void)pin_id; (void)level; }
 
-static int cmd(I2C_HandleTypeDef* i2c, uint8_t addr, uint8_t c){
+static int i2c_cmd(I2C_HandleTypeDef* i2c, uint8_t addr, uint8_t c){
   uint8_t buf[2] = {0x00, c};
   return (HAL_I2C_Master_Transmit(i2c, addr<<1, buf, 2, 1000) == HAL_OK) ? SGFX_OK : -1;
 }
 
-static int data(I2C_HandleTypeDef* i2c, uint8_t addr, const void* p, size_t n){
+static int i2c_data(I2C_HandleTypeDef* i2c, uint8_t addr, const void* p, size_t n){
   // Chunk to avoid large blocking writes
   const uint8_t* b = (const uint8_t*)p;
   uint8_t t[32];
@@ -38,12 +40,12 @@ static int data(I2C_HandleTypeDef* i2c, uint8_t addr, const void* p, size_t n){
 
 static int stm_write_cmd(sgfx_bus_t* b, uint8_t cmd){
   stm_i2c_ctx_t* c = (stm_i2c_ctx_t*)b->user;
-  return cmd(&hi2c_sgfx, c->addr, cmd);
+  return i2c_cmd(c->i2c, c->addr, cmd);
 }
 
 static int stm_write_data(sgfx_bus_t* b, const void* buf, size_t len){
   stm_i2c_ctx_t* c = (stm_i2c_ctx_t*)b->user;
-  return data(&hi2c_sgfx, c->addr, buf, len);
+  return i2c_data(c->i2c, c->addr, buf, len);
 }
 
 static int stm_write_repeat(sgfx_bus_t* b, const void* unit, size_t unit_bytes, size_t count){
@@ -67,6 +69,7 @@ int sgfx_hal_make_i2c(sgfx_bus_t* out, const sgfx_hal_cfg_i2c_t* cfg){
   if (!out || !cfg) return -1;
   stm_i2c_ctx_t* c = (stm_i2c_ctx_t*)calloc(1, sizeof(*c));
   if (!c) return -1;
+  c->i2c = cfg->port ? (I2C_HandleTypeDef*)cfg->port : &hi2c_sgfx;
   c->addr = cfg->addr;
   out->ops = &STM_I2C_OPS;
   out->user = c;
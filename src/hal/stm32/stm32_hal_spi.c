@@ -2,6 +2,7 @@
 
 #include "sgfx_hal.h"
 #include "sgfx.h"
+#include <stdlib.h>
 #include <string.h>
 #include "stm32_hal.h" /* see note below */
 
@@ -17,6 +18,7 @@
  */
 
 typedef struct {
+  SPI_HandleTypeDef* spi;   /* cfg->port, else &hspi_sgfx */
   uint32_t hz;
 } stm_spi_ctx_t;
 
@@ -28,7 +30,7 @@ extern void sgfx_gpio_set_rst(int level);
 extern void sgfx_gpio_set_bl(int level);
 
 static int stm_begin(sgfx_bus_t* b){ sgfx_gpio_set_cs(0); return SGFX_OK; }
-static void stm_end(sgfx_bus_t* b){ sgfx_gpio_set_cs(1); }
+static void stm_end(sgfx_bus_t* b){ sgfx_gpio_set_cs(1); free(b->user); b->user = NULL; }
 
 static inline void stm_delay(sgfx_bus_t* b, uint32_t ms){ (void)b; sgfx_delay_ms(ms); }
 
@@ -42,20 +44,19 @@ static inline void stm_gpio_set(sgfx_bus_t* b, int pin_id, bool level){
   }
 }
 
-static int tx(const void* data, size_t len){
-  return (HAL_SPI_Transmit(&hspi_sgfx, (uint8_t*)data, (uint16_t)len, 1000) == HAL_OK) ? SGFX_OK : -1;
+static int tx(sgfx_bus_t* b, const void* data, size_t len){
+  stm_spi_ctx_t* c = (stm_spi_ctx_t*)b->user;
+  return (HAL_SPI_Transmit(c->spi, (uint8_t*)data, (uint16_t)len, 1000) == HAL_OK) ? SGFX_OK : -1;
 }
 
 static int stm_write_cmd(sgfx_bus_t* b, uint8_t cmd){
-  (void)b;
   sgfx_gpio_set_dc(0);
-  return tx(&cmd, 1);
+  return tx(b, &cmd, 1);
 }
 
 static int stm_write_data(sgfx_bus_t* b, const void* buf, size_t len){
-  (void)b;
   sgfx_gpio_set_dc(1);
-  return tx(buf, len);
+  return tx(b, buf, len);
 }
 
 static int stm_write_repeat(sgfx_bus_t* b, const void* unit, size_t unit_bytes, size_t count){
@@ -81,11 +82,15 @@ static const sgfx_bus_ops_t STM_SPI_OPS = {
 
 int sgfx_hal_make_spi(sgfx_bus_t* out, const sgfx_hal_cfg_spi_t* cfg){
   if (!out || !cfg) return -1;
-  (void)cfg; // clocks and pins are expected to be configured in MX code / user init
+  // clocks and pins are expected to be configured in MX code / user init
+  stm_spi_ctx_t* c = (stm_spi_ctx_t*)calloc(1, sizeof(*c));
+  if (!c) return -1;
+  c->spi = cfg->port ? (SPI_HandleTypeDef*)cfg->port : &hspi_sgfx;
+  c->hz = cfg->hz;
   out->ops = &STM_SPI_OPS;
-  out->user = NULL;
+  out->user = c;
   out->hz_max = cfg->hz;
-  out->features = 0;
+  out->features = cfg->pin_rst >= 0 ? SGFX_BUS_HW_RESET : 0;   /* sgfx_gpio_set_rst wired */
   // Ensure CS is deasserted when idle (active low)
   sgfx_gpio_set_cs(1);
   return SGFX_OK;
@@ -0,0 +1,387 @@
+#if defined(SGFX_HAL_VIRTUAL)
+/*
+ * Host-side virtual panel: a sgfx_bus_ops_t that decodes the byte stream the
+ * drivers emit into an emulated controller RAM and counts the bus cost.
+ *
+ * ST77XX : DC=0 bytes are commands, DC=1 bytes are parameters or RAM data.
+ *          CASET/RASET set the window, RAMWR resets the pointer to its origin,
+ *          RAMWRC continues. MADCTL is recorded but not applied: RAM is kept
+ *          in the CASET=x / RASET=y space the drivers address. VSCRDEF /
+ *          VSCSAD only change what sgfx_vpanel_shown565 returns.
+ * SSD1306: every byte sent through write_cmd (I2C control 0x00) is a command
+ *          or a command argument; write_data bytes go to GDDRAM. COLUMNADDR /
+ *          PAGEADDR set the window in every addressing mode; the pointer then
+ *          advances according to MEMORYMODE.
+ */
+#include "sgfx_virtual.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- MIPI-DCS subset ---- */
+#define VP_SWRESET  0x01
+#define VP_INVOFF   0x20
+#define VP_INVON    0x21
+#define VP_DISPOFF  0x28
+#define VP_DISPON   0x29
+#define VP_CASET    0x2A
+#define VP_RASET    0x2B
+#define VP_RAMWR    0x2C
+#define VP_MADCTL   0x36
+#define VP_COLMOD   0x3A
+#define VP_VSCRDEF  0x33
+#define VP_VSCSAD   0x37
+#define VP_RAMWRC   0x3C
+
+/* ---- SSD1306 subset ---- */
+#define VS_MEMORYMODE 0x20
+#define VS_COLUMNADDR 0x21
+#define VS_PAGEADDR   0x22
+#define VS_NORMAL     0xA6
+#define VS_INVERT     0xA7
+#define VS_DISPOFF    0xAE
+#define VS_DISPON     0xAF
+
+static void vp_full_window(sgfx_vpanel_t* p){
+  p->x0 = 0; p->x1 = p->ram_w - 1;
+  p->y0 = 0; p->y1 = (p->kind == SGFX_VPANEL_SSD1306) ? (p->ram_h / 8) - 1 : p->ram_h - 1;
+  p->cx = p->x0; p->cy = p->y0;
+}
+
+int sgfx_vpanel_create(sgfx_vpanel_t* p, sgfx_vpanel_kind_t kind, int ram_w, int ram_h){
+  if (!p) return SGFX_ERR_INVAL;
+  memset(p, 0, sizeof *p);
+  if (ram_w <= 0 || ram_h <= 0) return SGFX_ERR_INVAL;
+  if (kind == SGFX_VPANEL_SSD1306 && (ram_h & 7)) return SGFX_ERR_INVAL;
+  p->kind = kind;
+  p->ram_w = ram_w; p->ram_h = ram_h;
+  if (kind == SGFX_VPANEL_SSD1306){
+    p->ram1 = (uint8_t*)calloc((size_t)ram_w * (size_t)(ram_h / 8), 1);
+    if (!p->ram1) return SGFX_ERR_NOMEM;
+    p->mem_mode = 2; /* page addressing after reset */
+  } else {
+    p->ram565 = (uint16_t*)calloc((size_t)ram_w * (size_t)ram_h, sizeof(uint16_t));
+    if (!p->ram565) return SGFX_ERR_NOMEM;
+    p->colmod = 0x66;
+  }
+  p->vs_vsa = ram_h;
+  vp_full_window(p);
+  return SGFX_OK;
+}
+
+void sgfx_vpanel_destroy(sgfx_vpanel_t* p){
+  if (!p) return;
+  free(p->ram565); free(p->ram1);
+  memset(p, 0, sizeof *p);
+}
+
+void sgfx_vpanel_stats_reset(sgfx_vpanel_t* p){
+  if (p) memset(&p->stats, 0, sizeof p->stats);
+}
+
+uint16_t sgfx_vpanel_pixel565(const sgfx_vpanel_t* p, int x, int y){
+  if (!p || x < 0 || y < 0 || x >= p->ram_w || y >= p->ram_h) return 0;
+  if (p->kind == SGFX_VPANEL_SSD1306)
+    return (p->ram1[(y >> 3) * p->ram_w + x] >> (y & 7)) & 1u ? 0xFFFFu : 0x0000u;
+  return p->ram565[(size_t)y * p->ram_w + x];
+}
+
+uint16_t sgfx_vpanel_shown565(const sgfx_vpanel_t* p, int x, int y){
+  if (!p || p->kind != SGFX_VPANEL_ST77XX || y < 0 || y >= p->ram_h) return sgfx_vpanel_pixel565(p, x, y);
+  const int my = (p->madctl & 0x80) != 0;
+  int s = my ? p->ram_h - 1 - y : y;          /* scan line */
+  int t = p->vs_tfa, n = p->vs_vsa;
+  if (n > 0 && s >= t && s < t + n)
+    s = t + ((s - t) + (p->vs_ssa - t) % n + n) % n;
+  return sgfx_vpanel_pixel565(p, x, my ? p->ram_h - 1 - s : s);
+}
+
+int sgfx_vpanel_dump_ppm(const sgfx_vpanel_t* p, const char* path){
+  if (!p || !path) return SGFX_ERR_INVAL;
+  FILE* f = fopen(path, "wb");
+  if (!f) return SGFX_ERR_EIO;
+  fprintf(f, "P6\n%d %d\n255\n", p->ram_w, p->ram_h);
+  for (int y = 0; y < p->ram_h; ++y){
+    for (int x = 0; x < p->ram_w; ++x){
+      uint16_t v = sgfx_vpanel_pixel565(p, x, y);
+      uint8_t rgb[3] = {
+        (uint8_t)(((v >> 11) & 0x1F) * 255 / 31),
+        (uint8_t)(((v >>  5) & 0x3F) * 255 / 63),
+        (uint8_t)(( v        & 0x1F) * 255 / 31)
+      };
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  return fclose(f) == 0 ? SGFX_OK : SGFX_ERR_EIO;
+}
+
+/* ======================= ST77xx (MIPI-DCS) ======================= */
+
+static void st_cmd(sgfx_vpanel_t* p, uint8_t c){
+  p->cmd = c; p->nargs = 0; p->want = -1;
+  p->ramwr = 0; p->have_hi = 0;
+  switch (c){
+    case VP_SWRESET: vp_full_window(p); p->madctl = 0; p->colmod = 0x66;
+                     p->vs_tfa = 0; p->vs_vsa = p->ram_h; p->vs_ssa = 0; break;
+    case VP_INVOFF:  p->inverted = 0; break;
+    case VP_INVON:   p->inverted = 1; break;
+    case VP_DISPOFF: p->display_on = 0; break;
+    case VP_DISPON:  p->display_on = 1; break;
+    case VP_CASET:
+    case VP_RASET:   p->want = 4; p->stats.addr_cmds++; break;
+    case VP_MADCTL:
+    case VP_COLMOD:  p->want = 1; break;
+    case VP_VSCRDEF: p->want = 6; break;
+    case VP_VSCSAD:  p->want = 2; break;
+    case VP_RAMWR:   p->ramwr = 1; p->cx = p->x0; p->cy = p->y0; p->stats.ram_writes++; break;
+    case VP_RAMWRC:  p->ramwr = 1; p->stats.ram_writes++; break;
+    default: break;  /* vendor/init commands: parameters are swallowed */
+  }
+}
+
+static void st_apply(sgfx_vpanel_t* p){
+  int a = (p->args[0] << 8) | p->args[1];
+  int b = (p->args[2] << 8) | p->args[3];
+  switch (p->cmd){
+    case VP_CASET:
+      if (a != p->x0 || b != p->x1) p->stats.windows++;
+      p->x0 = a; p->x1 = b;
+      break;
+    case VP_RASET:
+      if (a != p->y0 || b != p->y1) p->stats.windows++;
+      p->y0 = a; p->y1 = b;
+      break;
+    case VP_MADCTL: p->madctl = p->args[0]; break;
+    case VP_COLMOD: p->colmod = p->args[0]; break;
+    case VP_VSCRDEF: p->vs_tfa = a; p->vs_vsa = b; break;
+    case VP_VSCSAD:  p->vs_ssa = a; break;
+    default: break;
+  }
+}
+
+static void st_pixel(sgfx_vpanel_t* p, uint16_t v){
+  if (p->cx >= 0 && p->cy >= 0 && p->cx < p->ram_w && p->cy < p->ram_h){
+    p->ram565[(size_t)p->cy * p->ram_w + p->cx] = v;
+    p->stats.px_written++;
+  } else {
+    p->stats.px_dropped++;
+  }
+  if (++p->cx > p->x1){
+    p->cx = p->x0;
+    if (++p->cy > p->y1) p->cy = p->y0;
+  }
+}
+
+static void st_byte(sgfx_vpanel_t* p, uint8_t v){
+  if (p->ramwr){
+    if (!p->have_hi){ p->hi = v; p->have_hi = 1; return; }
+    p->have_hi = 0;
+    st_pixel(p, (uint16_t)((p->hi << 8) | v));
+    return;
+  }
+  if (p->want < 0) return;
+  if (p->nargs < p->want){
+    p->args[p->nargs++] = v;
+    if (p->nargs == p->want) st_apply(p);
+  }
+}
+
+/* ======================= SSD1306 ======================= */
+
+static int ssd_args_for(uint8_t c){
+  switch (c){
+    case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5:
+    case 0xD9: case 0xDA: case 0xDB: case VS_MEMORYMODE: return 1;
+    case VS_COLUMNADDR: case VS_PAGEADDR: case 0xA3:     return 2;
+    case 0x29: case 0x2A:                                return 5;
+    case 0x26: case 0x27:                                return 6;
+    default:                                             return 0;
+  }
+}
+
+static void ssd_apply(sgfx_vpanel_t* p){
+  int a = p->args[0], b = p->args[1];
+  switch (p->cmd){
+    case VS_MEMORYMODE: p->mem_mode = (uint8_t)(a & 3); break;
+    case VS_COLUMNADDR:
+      if (a != p->x0 || b != p->x1) p->stats.windows++;
+      p->x0 = a; p->x1 = b; p->cx = a;
+      break;
+    case VS_PAGEADDR:
+      if (a != p->y0 || b != p->y1) p->stats.windows++;
+      p->y0 = a; p->y1 = b; p->cy = a;
+      break;
+    default: break;
+  }
+}
+
+static void ssd_cmd_byte(sgfx_vpanel_t* p, uint8_t c){
+  p->ramwr = 0;
+  if (p->nargs < p->want){
+    p->args[p->nargs++] = c;
+    if (p->nargs == p->want){ ssd_apply(p); p->want = 0; }
+    return;
+  }
+  p->cmd = c; p->nargs = 0; p->want = ssd_args_for(c);
+  if (c == VS_COLUMNADDR || c == VS_PAGEADDR) p->stats.addr_cmds++;
+  if (c <= 0x0F)                   p->cx = (p->cx & 0xF0) | (c & 0x0F);       /* page mode low col  */
+  else if (c <= 0x1F)              p->cx = (p->cx & 0x0F) | ((c & 0x0F) << 4); /* page mode high col */
+  else if (c >= 0xB0 && c <= 0xB7) p->cy = c & 7;                              /* page mode page     */
+  else if (c == VS_NORMAL)  p->inverted = 0;
+  else if (c == VS_INVERT)  p->inverted = 1;
+  else if (c == VS_DISPOFF) p->display_on = 0;
+  else if (c == VS_DISPON)  p->display_on = 1;
+}
+
+static void ssd_byte(sgfx_vpanel_t* p, uint8_t v){
+  if (!p->ramwr){ p->ramwr = 1; p->stats.ram_writes++; }
+  if (p->cx >= 0 && p->cy >= 0 && p->cx < p->ram_w && p->cy < p->ram_h / 8){
+    p->ram1[p->cy * p->ram_w + p->cx] = v;
+    p->stats.px_written++;
+  } else {
+    p->stats.px_dropped++;
+  }
+  switch (p->mem_mode){
+    case 0: /* horizontal */
+      if (++p->cx > p->x1){ p->cx = p->x0; if (++p->cy > p->y1) p->cy = p->y0; }
+      break;
+    case 1: /* vertical */
+      if (++p->cy > p->y1){ p->cy = p->y0; if (++p->cx > p->x1) p->cx = p->x0; }
+      break;
+    default: /* page: wrap within the page */
+      if (++p->cx > p->x1) p->cx = p->x0;
+      break;
+  }
+}
+
+/* ======================= Bus ops ======================= */
+
+static inline sgfx_vpanel_t* vp_of(sgfx_bus_t* b){ return (sgfx_vpanel_t*)b->user; }
+
+static void vp_feed(sgfx_vpanel_t* p, const uint8_t* s, size_t n){
+  if (p->kind == SGFX_VPANEL_SSD1306){ while (n--) ssd_byte(p, *s++); }
+  else                               { while (n--) st_byte(p, *s++); }
+}
+
+/* Complete the oldest queued async transfer. */
+static int vp_retire(sgfx_vpanel_t* p){
+  if (!p->q_count) return SGFX_OK;
+  vp_feed(p, p->q[p->q_head].buf, p->q[p->q_head].len);
+  p->q_head = (p->q_head + 1) % SGFX_VPANEL_ASYNC_DEPTH;
+  p->q_count--;
+  return SGFX_OK;
+}
+
+/* A sync op while transfers are queued: real HALs would interleave or fail;
+ * count it and drain first so RAM stays in program order. */
+static void vp_sync(sgfx_vpanel_t* p){
+  if (!p->q_count) return;
+  p->stats.async_overlap++;
+  while (p->q_count) vp_retire(p);
+}
+
+static int vp_begin(sgfx_bus_t* b){ (void)b; return SGFX_OK; }
+static void vp_end(sgfx_bus_t* b){ (void)b; }
+
+static int vp_write_cmd(sgfx_bus_t* b, uint8_t cmd){
+  sgfx_vpanel_t* p = vp_of(b);
+  vp_sync(p);
+  p->stats.cs_toggles++;
+  p->stats.cmds++;
+  if (p->kind == SGFX_VPANEL_SSD1306) ssd_cmd_byte(p, cmd);
+  else                                st_cmd(p, cmd);
+  return SGFX_OK;
+}
+
+static int vp_write_data(sgfx_bus_t* b, const void* buf, size_t len){
+  sgfx_vpanel_t* p = vp_of(b);
+  if (!buf && len) return SGFX_ERR_INVAL;
+  vp_sync(p);
+  p->stats.cs_toggles++;
+  p->stats.data_bytes += (uint32_t)len;
+  vp_feed(p, (const uint8_t*)buf, len);
+  return SGFX_OK;
+}
+
+/* One CS frame for the whole run. */
+static int vp_write_cmds(sgfx_bus_t* b, const uint8_t* seq, size_t len){
+  sgfx_vpanel_t* p = vp_of(b);
+  if (!seq && len) return SGFX_ERR_INVAL;
+  vp_sync(p);
+  p->stats.cs_toggles++;
+  for (size_t i = 0; i + 1 < len; i += 2u + seq[i+1]){
+    if (i + 2u + seq[i+1] > len) return SGFX_ERR_INVAL;
+    p->stats.cmds++;
+    if (p->kind == SGFX_VPANEL_SSD1306){   /* arguments are command bytes too */
+      p->stats.cmds += seq[i+1];
+      for (size_t k = 0; k <= seq[i+1]; ++k) ssd_cmd_byte(p, seq[i + (k ? k + 1 : 0)]);
+      continue;
+    }
+    p->stats.data_bytes += seq[i+1];
+    st_cmd(p, seq[i]);
+    vp_feed(p, seq + i + 2, seq[i+1]);
+  }
+  return SGFX_OK;
+}
+
+static int vp_write_repeat(sgfx_bus_t* b, const void* unit, size_t unit_bytes, size_t count){
+  sgfx_vpanel_t* p = vp_of(b);
+  if (!unit || !unit_bytes) return SGFX_ERR_INVAL;
+  vp_sync(p);
+  p->stats.cs_toggles++;
+  p->stats.repeats++;
+  p->stats.data_bytes += (uint32_t)(unit_bytes * count);
+  while (count--) vp_feed(p, (const uint8_t*)unit, unit_bytes);
+  return SGFX_OK;
+}
+
+/* RGB565 words go out in memory order, like the MCU HALs: little-endian hosts
+ * need SGFX_RGB565_BYTESWAP in the driver to land correct colours. */
+static int vp_write_pixels(sgfx_bus_t* b, const void* px, size_t count, sgfx_pixfmt_t src_fmt){
+  size_t bpp = (src_fmt == SGFX_FMT_RGB565) ? 2u : 1u;
+  return vp_write_data(b, px, count * bpp);
+}
+
+static int vp_write_data_async(sgfx_bus_t* b, const void* buf, size_t len){
+  sgfx_vpanel_t* p = vp_of(b);
+  if (!buf && len) return SGFX_ERR_INVAL;
+  if (p->q_count == SGFX_VPANEL_ASYNC_DEPTH) return SGFX_ERR_EIO;
+  int slot = (p->q_head + p->q_count) % SGFX_VPANEL_ASYNC_DEPTH;
+  p->q[slot].buf = (const uint8_t*)buf;
+  p->q[slot].len = len;
+  p->q_count++;
+  p->stats.cs_toggles++;
+  p->stats.async_xfers++;
+  p->stats.data_bytes += (uint32_t)len;
+  return SGFX_OK;
+}
+
+static int vp_wait_async(sgfx_bus_t* b){ return vp_retire(vp_of(b)); }
+
+static int vp_read_data(sgfx_bus_t* b, void* buf, size_t len){
+  (void)b; (void)buf; (void)len; return SGFX_ERR_NOSUP;
+}
+
+static void vp_delay(sgfx_bus_t* b, uint32_t ms){ vp_of(b)->stats.delay_ms += ms; }
+
+static void vp_gpio_set(sgfx_bus_t* b, int pin_id, bool level){ (void)b; (void)pin_id; (void)level; }
+
+static const sgfx_bus_ops_t VP_OPS = {
+  .begin = vp_begin, .end = vp_end,
+  .write_cmd = vp_write_cmd, .write_data = vp_write_data,
+  .write_repeat = vp_write_repeat, .write_pixels = vp_write_pixels,
+  .read_data = vp_read_data, .delay_ms = vp_delay, .gpio_set = vp_gpio_set,
+  .write_data_async = vp_write_data_async, .wait_async = vp_wait_async,
+  .write_cmds = vp_write_cmds
+};
+
+int sgfx_vpanel_make_bus(sgfx_bus_t* out, sgfx_vpanel_t* p){
+  if (!out || !p) return SGFX_ERR_INVAL;
+  out->ops = &VP_OPS;
+  out->user = p;
+  out->hz_max = 0;
+  out->features = 0;
+  return SGFX_OK;
+}
+
+#endif /* SGFX_HAL_VIRTUAL */